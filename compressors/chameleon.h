@@ -17,6 +17,7 @@ PERFORMANCE OF THIS SOFTWARE.
 #define CLOWNLZSS_COMPRESSORS_CHAMELEON_H
 
 #include <utility>
+#include <vector>
 
 #include "../bitfield.h"
 #include "clownlzss.h"
@@ -43,67 +44,86 @@ namespace ClownLZSS
 					return 0;                 /* In the event a match cannot be compressed */
 			}
 
-			template<typename T>
-			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output)
+			struct Format
 			{
-				/* Produce a series of LZSS compression matches. */
-				/* Yes, the first two values really are lower than usual by 1. */
-				ClownLZSS::Matches matches;
-				std::size_t total_matches;
-				if (!ClownLZSS::FindOptimalMatches(-1, 0xFF, 0x7FF, nullptr, 1 + 8, GetMatchCost, data, 1, data_size, &matches, &total_matches, nullptr))
-					return false;
+				static constexpr int filler_value = -1;
+				static constexpr std::size_t maximum_match_length = 0xFF;
+				static constexpr std::size_t maximum_match_distance = 0x7FF;
+				static constexpr std::size_t bytes_per_value = 1;
+				static constexpr std::size_t literal_cost = 1 + 8;
+				static constexpr MatchCostCallback GetMatchCost = Chameleon::GetMatchCost;
+				static constexpr std::size_t cost_distance_tiers[] = {0xFF, 0x7FF};
+			};
 
+			template<typename T>
+			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output, Workspace &workspace, const ClownLZSS_Settings &settings)
+			{
 				/* Track the location of the header... */
 				const auto header_position = output.Tell();
 
 				/* ...and insert a placeholder there. */
 				output.WriteBE16(0);
 
+				/* Unlike many other LZSS formats, Chameleon stores the descriptor fields separately from the rest of the data,
+				   so the literals and offset/length pairs are held back until the descriptor fields are complete. */
+				std::vector<unsigned char> literals_and_pairs;
+
 				{
 					BitFieldWriter<decltype(output)> descriptor_bits(output);
 
 					/* Produce Chameleon-formatted data. */
-					/* Unlike many other LZSS formats, Chameleon stores the descriptor fields separately from the rest of the data. */
-					/* Iterate over the compression matches, outputting just the descriptor fields. */
-					for (ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
+					const auto write_matches = [&](const unsigned char* const window, std::size_t, const ClownLZSS_Match* const matches, const std::size_t total_matches)
 					{
-						if (CLOWNLZSS_MATCH_IS_LITERAL(match))
-						{
-							descriptor_bits.Push(1);
-						}
-						else
+						for (const ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
 						{
-							const std::size_t distance = match->destination - match->source;
-							const std::size_t length = match->length;
-
-							if (length >= 2 && length <= 3 && distance < 0x100)
+							if (CLOWNLZSS_MATCH_IS_LITERAL(match))
 							{
-								descriptor_bits.Push(0);
-								descriptor_bits.Push(0);
-								descriptor_bits.Push(length == 3);
-							}
-							else if (length >= 3 && length <= 5)
-							{
-								descriptor_bits.Push(0);
 								descriptor_bits.Push(1);
-								descriptor_bits.Push(!!(distance & (1 << 10)));
-								descriptor_bits.Push(!!(distance & (1 << 9)));
-								descriptor_bits.Push(!!(distance & (1 << 8)));
-								descriptor_bits.Push(length == 5);
-								descriptor_bits.Push(length == 4);
+								literals_and_pairs.push_back(window[match->destination]);
 							}
-							else /*if (length >= 6)*/
+							else
 							{
-								descriptor_bits.Push(0);
-								descriptor_bits.Push(1);
-								descriptor_bits.Push(!!(distance & (1 << 10)));
-								descriptor_bits.Push(!!(distance & (1 << 9)));
-								descriptor_bits.Push(!!(distance & (1 << 8)));
-								descriptor_bits.Push(1);
-								descriptor_bits.Push(1);
+								const std::size_t distance = match->destination - match->source;
+								const std::size_t length = match->length;
+
+								if (length >= 2 && length <= 3 && distance < 0x100)
+								{
+									descriptor_bits.Push(0);
+									descriptor_bits.Push(0);
+									descriptor_bits.Push(length == 3);
+									literals_and_pairs.push_back(distance);
+								}
+								else if (length >= 3 && length <= 5)
+								{
+									descriptor_bits.Push(0);
+									descriptor_bits.Push(1);
+									descriptor_bits.Push(!!(distance & (1 << 10)));
+									descriptor_bits.Push(!!(distance & (1 << 9)));
+									descriptor_bits.Push(!!(distance & (1 << 8)));
+									descriptor_bits.Push(length == 5);
+									descriptor_bits.Push(length == 4);
+									literals_and_pairs.push_back(distance & 0xFF);
+								}
+								else /*if (length >= 6)*/
+								{
+									descriptor_bits.Push(0);
+									descriptor_bits.Push(1);
+									descriptor_bits.Push(!!(distance & (1 << 10)));
+									descriptor_bits.Push(!!(distance & (1 << 9)));
+									descriptor_bits.Push(!!(distance & (1 << 8)));
+									descriptor_bits.Push(1);
+									descriptor_bits.Push(1);
+									literals_and_pairs.push_back(distance & 0xFF);
+									literals_and_pairs.push_back(length);
+								}
 							}
 						}
-					}
+					};
+
+					/* Produce a series of LZSS compression matches. */
+					/* Yes, the first two values really are lower than usual by 1. */
+					if (!ClownLZSS::ParseOptimalMatches<Format>(workspace, settings, data, data_size, write_matches))
+						return false;
 
 					/* Add the terminator match. */
 					descriptor_bits.Push(0);
@@ -121,33 +141,9 @@ namespace ClownLZSS
 				output.WriteBE16(current_position - header_position - 2);
 				output.Seek(current_position);
 
-				/* Iterate over the compression matches again, now outputting just the literals and offset/length pairs. */
-				for (ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
-				{
-					if (CLOWNLZSS_MATCH_IS_LITERAL(match))
-					{
-						output.Write(data[match->destination]);
-					}
-					else
-					{
-						const std::size_t distance = match->destination - match->source;
-						const std::size_t length = match->length;
-
-						if (length >= 2 && length <= 3 && distance < 0x100)
-						{
-							output.Write(distance);
-						}
-						else if (length >= 3 && length <= 5)
-						{
-							output.Write(distance & 0xFF);
-						}
-						else /*if (length >= 6)*/
-						{
-							output.Write(distance & 0xFF);
-							output.Write(length);
-						}
-					}
-				}
+				/* Now output the literals and offset/length pairs. */
+				for (const auto value : literals_and_pairs)
+					output.Write(value);
 
 				/* Add the terminator match. */
 				output.Write(0);
@@ -159,21 +155,40 @@ namespace ClownLZSS
 	}
 
 	template<typename T>
-	bool ChameleonCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	bool ChameleonCompress(const unsigned char* const data, const std::size_t data_size, T &&output, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return Chameleon::Compress(data, data_size, output_wrapped);
+		return Chameleon::Compress(data, data_size, output_wrapped, workspace, settings);
 	}
 
 	template<typename T>
-	bool ModuledChameleonCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	bool ChameleonCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	{
+		Workspace workspace;
+		return ChameleonCompress(data, data_size, std::forward<T>(output), workspace);
+	}
+
+	template<typename T>
+	bool ModuledChameleonCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return ModuledCompressionWrapper(data, data_size, output_wrapped, Chameleon::Compress, module_size, 2);
+		return ModuledCompressionWrapper(data, data_size, output_wrapped, Chameleon::Compress, module_size, 2, workspace, settings);
+	}
+
+	template<typename T>
+	bool ModuledChameleonCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	{
+		Workspace workspace;
+		return ModuledChameleonCompress(data, data_size, std::forward<T>(output), module_size, workspace);
+	}
+
+	inline ClownLZSS_CandidateFormat GetChameleonCandidateFormat()
+	{
+		return GetCandidateFormat<Internal::Chameleon::Format>();
 	}
 }
 
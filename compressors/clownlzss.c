@@ -15,223 +15,4148 @@ PERFORMANCE OF THIS SOFTWARE.
 
 #include "clownlzss.h"
 
+#include <limits.h>
 #include <stddef.h>
+#ifndef CLOWNLZSS_FREESTANDING
 #include <stdlib.h>
+#include <string.h>
+#endif
 
-int ClownLZSS_FindOptimalMatches(
+/* On x86, the string comparisons can use SSE2 and AVX2, which are detected at runtime. */
+#if !defined(CLOWNLZSS_FREESTANDING) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CLOWNLZSS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* The window links and suffix array indices only ever need 32 bits. */
+#if UINT_MAX >= 0xFFFFFFFF
+typedef unsigned int ClownLZSS_Link;
+#else
+typedef unsigned long ClownLZSS_Link;
+#endif
+
+#define CLOWNLZSS_LINK_NONE ((ClownLZSS_Link)0xFFFFFFFF)
+
+/* The hash-chain key never covers more than this many bytes. */
+#define CLOWNLZSS_MAXIMUM_KEY_BYTES 4
+
+#define CLOWNLZSS_MINIMUM_HASH_BITS 8
+#define CLOWNLZSS_MAXIMUM_HASH_BITS 16
+
+/* Windows at least this large use the binary tree finder by default. */
+#define CLOWNLZSS_LARGE_WINDOW 0x1000
+
+/* Match costs are tabulated for lengths up to this; anything longer goes to the callback. */
+#define CLOWNLZSS_MAXIMUM_TABULATED_LENGTH 0x1000
+
+/* Matches of words compare this many of them directly before using the byte comparison. */
+#define CLOWNLZSS_INLINE_COMPARE_VALUES 4
+
+/* When the hash-chains are searched in parallel, each job covers this many positions, and has room for this many matches. */
+#define CLOWNLZSS_JOB_VALUES 0x1000
+#define CLOWNLZSS_JOB_MATCHES 0x8000
+
+/* The most earlier strings that the lazy parser compares with each string. */
+#define CLOWNLZSS_LAZY_MAXIMUM_CHAIN_LENGTH 32
+
+/* How many strings past the ones that it skips the hash-chain finder checks for the rest of the chain, before walking it instead. */
+#define CLOWNLZSS_SKIP_PROBES 8
+
+/* The longest period that is looked for in the costs of long matches. */
+#define CLOWNLZSS_MAXIMUM_COST_TAIL_PERIOD 0x40
+
+/* Every array in the workspace begins at a multiple of this. */
+#define CLOWNLZSS_WORKSPACE_ALIGNMENT sizeof(size_t)
+
+/* Marks the ends of the shortest path, and nodes that have not been reached yet. */
+#define CLOWNLZSS_GRAPH_DUMMY ((size_t)-1)
+
+typedef size_t (*CompareBytesFunction)(const unsigned char *a, const unsigned char *b, size_t maximum);
+
+typedef struct CutPoints
+{
+	/* The furthest node that any edge so far could reach. */
+	size_t furthest_edge;
+	/* The last position that no edge reached past, meaning that every path passes through it. */
+	size_t last_cut_point;
+} CutPoints;
+
+typedef struct LiteralRuns
+{
+	const size_t *length_tiers;
+	const size_t *header_costs;
+	size_t total_tiers;
+	size_t value_cost;
+	/* Each run is a straight line of costs from its source, so the cheapest run to a node is a sliding window minimum,
+	   which is kept in a queue per tier and only looked at once the node is reached. If this is false, then the runs
+	   have to be relaxed one length at a time instead, like an extra matches callback would. */
+	int deferred;
+	/* These are all ring buffers of `capacity` entries, which is enough for every position that one run can span. */
+	size_t capacity;
+	/* The positions that have been visited, in order, for runs to start at. */
+	size_t *sources;
+	size_t total_sources;
+	/* For each tier, the sources that could still be the cheapest, from the cheapest to the most recent. */
+	size_t *queues;
+	size_t *queue_starts;
+	size_t *queue_lengths;
+	/* For each tier, how many of the sources have been long enough ago to join it. */
+	size_t *joined_sources;
+	/* The last node that has had the runs to it resolved. */
+	size_t resolved_node;
+} LiteralRuns;
+
+typedef struct RepeatEdge
+{
+	/* The source of the last edge that the parser itself relaxed to the node, and the distance that a match could repeat
+	   after it. The extra matches callback does not set these, so, if the node's edge came from somewhere else, then it
+	   was the callback's, and the distance is the same as at the edge's source. 0 means that there is no distance yet. */
+	size_t source;
+	size_t distance;
+} RepeatEdge;
+
+/* Half the size of `ClownLZSS_GraphEdge` on 64-bit CPUs, so that the graph is kinder to the cache. It can only be used if
+   every position and cost fits in 32 bits, and if there is no extra matches callback, as that needs the full-size nodes.
+   It lives in the same memory as the full-size graph would, which leaves room for widening the matches at the end. */
+typedef struct CompactGraphEdge
+{
+	union
+	{
+		ClownLZSS_Link cost;
+		ClownLZSS_Link next_node_index;
+	} u;
+	ClownLZSS_Link previous_node_index;
+	ClownLZSS_Link match_offset;
+} CompactGraphEdge;
+
+typedef struct FoundMatch
+{
+	/* A match that has been found, but not relaxed yet. An entry with a distance of 0 comes before each position's
+	   matches instead, with its lengths being how many matches follow it, and the longest of them. */
+	size_t distance;
+	size_t minimum_length;
+	size_t maximum_length;
+} FoundMatch;
+
+typedef struct CompactMatch
+{
+	ClownLZSS_Link source;
+	ClownLZSS_Link destination;
+	ClownLZSS_Link length;
+} CompactMatch;
+
+#define CLOWNLZSS_TOTAL_RECENT_HINT_DISTANCES 4
+
+typedef struct HintCursor
+{
+	/* The first hint that has not been reached yet. */
+	size_t next_hint;
+	/* The distances of the last few hints that have been reached, most recent first, or 0 where there are none yet.
+	   Formats share a lot of matches, and their distances are likely to be used again. */
+	size_t recent_distances[CLOWNLZSS_TOTAL_RECENT_HINT_DISTANCES];
+} HintCursor;
+
+typedef struct Parameters
+{
+	int filler_value;
+	size_t maximum_match_length;
+	size_t maximum_match_distance;
+	void (*extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user);
+	/* Used instead of the above when not NULL (see `ClownLZSS_Settings::extra_run_matches_callback`). */
+	void (*extra_run_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, size_t run_length, ClownLZSS_GraphEdge *node_meta_array, void *user);
+	size_t literal_cost;
+	size_t (*match_cost_callback)(size_t distance, size_t length, void *user);
+	const unsigned char *data;
+	size_t bytes_per_value;
+	size_t total_values;
+	void *user;
+
+	/* How far past its position the extra matches callback can relax a node. */
+	size_t maximum_extra_match_length;
+
+	/* The shortest match that could ever be part of the shortest path. */
+	size_t minimum_match_length;
+	/* Positions are 'padded': the first `padding` of them are the virtual filler
+	   values that come before the data, and the data itself begins after them. */
+	size_t padding;
+	/* If `padding` is not 0, then this is a copy of the filler values, followed by the start of the data (see `GetPaddedBytes`). */
+	const unsigned char *padded_head;
+	/* The first `history` values of the data are only a dictionary for later values to match against, and the
+	   parse begins after them. It ends at `parse_end`, though matches can extend past it up to `total_values`. */
+	size_t history;
+	size_t parse_end;
+	/* If not 0, then this many nodes at the start of the graph were kept from a checkpoint, instead of being reset. */
+	size_t kept_nodes;
+	/* If not NULL, then the points that every path passes through are recorded here. */
+	CutPoints *cut_points;
+	/* If not NULL, then these matches are relaxed along with the ones that the match finder finds (see `ClownLZSS_Settings::hints`). */
+	const ClownLZSS_Match *hints;
+	size_t total_hints;
+	HintCursor *hint_cursor;
+	/* If not NULL, then these are the candidates that the candidates finder reads, without their header (see `ClownLZSS_Settings::candidates`). */
+	const unsigned char *candidates;
+	size_t candidates_size;
+	/* If not NULL, then runs of literals with their own costs are relaxed along with the other edges. */
+	LiteralRuns *literal_runs;
+	/* If not NULL, then matches that repeat the distance of the last match on the path cost `repeat_match_cost` for up to
+	   `maximum_repeat_match_length` values, and the distance of each node is kept here. Only the cheapest path to each node
+	   is kept, so a more expensive path that would leave a more useful distance behind is never considered. */
+	RepeatEdge *repeats;
+	size_t maximum_repeat_match_length;
+	size_t repeat_match_cost;
+	/* The distance that can be repeated at the start of the parse. */
+	size_t repeat_distance;
+	/* If not NULL, then how full the descriptor field is counts as part of each position, and this graph has
+	   `descriptor_field_bits` nodes per position, one for each number of bits that the field could have in it. Each
+	   node's previous node index is an index into this graph, rather than a position. The ordinary graph is only used
+	   to collect the edges of the extra matches callback, and to hold the shortest path once it has been found. */
+	ClownLZSS_GraphEdge *descriptor_graph;
+	size_t descriptor_field_bits;
+	/* Where the run of identical values that the last visited position is in ends, so that the run length that is given to
+	   the extra run matches callback only has to be found once per run, instead of once per position. */
+	size_t *run_end;
+	ClownLZSS_Parser parser;
+	/* If `total_jobs` is not 0, then the hash-chains are searched this many parts at a time (see `ClownLZSS_Settings::run_jobs`). */
+	void (*run_jobs)(void (*job)(void *job_user, size_t index), void *job_user, size_t total_jobs, void *user);
+	void *run_jobs_user;
+	size_t total_jobs;
+	/* The effort settings, with `(size_t)-1` in place of 0 for no limit. */
+	size_t maximum_chain_length;
+	size_t nice_match_length;
+	size_t good_match_length;
+	/* If true, then the graph is made of `CompactGraphEdge`s, despite its type. */
+	int compact_graph;
+	/* The fastest string comparison that this CPU supports. */
+	CompareBytesFunction compare_bytes;
+	/* If not NULL, the match costs are looked up from this instead of calling the callback.
+	   It has a row for each distance tier, which is indexed by length. */
+	size_t *cost_table;
+	size_t cost_table_width;
+	const size_t *cost_distance_tiers;
+	/* From `cost_tail_length` onwards, a match costs `cost_tail_step` more than the one that is `cost_tail_period`
+	   values shorter at the same distance. A period of 0 means that there is no such pattern, or that it cannot be used. */
+	size_t cost_tail_length;
+	size_t cost_tail_period;
+	size_t cost_tail_step;
+} Parameters;
+
+/*******************\
+* String comparison *
+\*******************/
+
+/* These all return how many bytes at the start of `a` and `b` are the same, up to `maximum`. */
+
+static size_t CompareBytesScalar(const unsigned char* const a, const unsigned char* const b, const size_t maximum)
+{
+	size_t length;
+
+	length = 0;
+
+#ifndef CLOWNLZSS_FREESTANDING
+	/* Compare a word at a time, and only fall back on bytes to find where a mismatching word differs. */
+	while (length + sizeof(unsigned long) <= maximum)
+	{
+		unsigned long a_word, b_word;
+
+		memcpy(&a_word, &a[length], sizeof(a_word));
+		memcpy(&b_word, &b[length], sizeof(b_word));
+
+		if (a_word != b_word)
+			break;
+
+		length += sizeof(unsigned long);
+	}
+#endif
+
+	while (length < maximum && a[length] == b[length])
+		++length;
+
+	return length;
+}
+
+#ifdef CLOWNLZSS_X86_SIMD
+__attribute__((target("sse2"))) static size_t CompareBytesSSE2(const unsigned char* const a, const unsigned char* const b, const size_t maximum)
+{
+	size_t length;
+
+	length = 0;
+
+	while (length + 16 <= maximum)
+	{
+		const __m128i a_vector = _mm_loadu_si128((const __m128i*)&a[length]);
+		const __m128i b_vector = _mm_loadu_si128((const __m128i*)&b[length]);
+		const unsigned int mismatches = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(a_vector, b_vector)) ^ 0xFFFF;
+
+		if (mismatches != 0)
+			return length + __builtin_ctz(mismatches);
+
+		length += 16;
+	}
+
+	return length + CompareBytesScalar(&a[length], &b[length], maximum - length);
+}
+
+__attribute__((target("avx2"))) static size_t CompareBytesAVX2(const unsigned char* const a, const unsigned char* const b, const size_t maximum)
+{
+	size_t length;
+
+	length = 0;
+
+	while (length + 32 <= maximum)
+	{
+		const __m256i a_vector = _mm256_loadu_si256((const __m256i*)&a[length]);
+		const __m256i b_vector = _mm256_loadu_si256((const __m256i*)&b[length]);
+		const unsigned int mismatches = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a_vector, b_vector)) ^ 0xFFFFFFFF;
+
+		if (mismatches != 0)
+			return length + __builtin_ctz(mismatches);
+
+		length += 32;
+	}
+
+	return length + CompareBytesSSE2(&a[length], &b[length], maximum - length);
+}
+#endif
+
+static CompareBytesFunction ChooseCompareBytes(void)
+{
+#ifdef CLOWNLZSS_X86_SIMD
+	if (__builtin_cpu_supports("avx2"))
+		return CompareBytesAVX2;
+	else if (__builtin_cpu_supports("sse2"))
+		return CompareBytesSSE2;
+#endif
+
+	return CompareBytesScalar;
+}
+
+static int ValuesEqual(const unsigned char* const a, const unsigned char* const b, const size_t bytes_per_value)
+{
+	size_t i;
+
+	if (bytes_per_value == 2)
+		return a[0] == b[0] && a[1] == b[1];
+
+	for (i = 0; i < bytes_per_value; ++i)
+		if (a[i] != b[i])
+			return 0;
+
+	return 1;
+}
+
+static size_t CompareValues(const Parameters* const parameters, const unsigned char* const a, const unsigned char* const b, const size_t maximum_values)
+{
+	size_t length;
+
+	/* Only whole values count, so round down to the last value that matched completely. */
+	switch (parameters->bytes_per_value)
+	{
+		case 1:
+			return parameters->compare_bytes(a, b, maximum_values);
+
+		case 2:
+			/* Most of the strings in a chain differ within the first few words, which is quicker to find a word at a time. */
+			for (length = 0; length < maximum_values && length < CLOWNLZSS_INLINE_COMPARE_VALUES; ++length)
+				if (a[length * 2] != b[length * 2] || a[length * 2 + 1] != b[length * 2 + 1])
+					return length;
+
+			return length + (parameters->compare_bytes(&a[length * 2], &b[length * 2], (maximum_values - length) * 2) >> 1);
+
+		default:
+			return parameters->compare_bytes(a, b, maximum_values * parameters->bytes_per_value) / parameters->bytes_per_value;
+	}
+}
+
+static const unsigned char* GetPaddedBytes(const Parameters* const parameters, const size_t padded_byte_index)
+{
+	/* The filler values are not in front of the data in memory, so a string that begins in them is read from a copy of
+	   them instead. As that is followed by the start of the data, the whole string can be compared at once, like any other.
+	   The copy only needs to go as far as the longest match that begins in the filler values. */
+	const size_t padding_bytes = parameters->padding * parameters->bytes_per_value;
+
+	return padded_byte_index < padding_bytes ? &parameters->padded_head[padded_byte_index] : &parameters->data[padded_byte_index - padding_bytes];
+}
+
+static size_t GetPaddedHeadSize(const Parameters* const parameters)
+{
+	const size_t data_values = CLOWNLZSS_MIN(parameters->maximum_match_length, parameters->total_values);
+
+	/* A size of 0 means that there are no filler values, so there is no need for a copy of them. */
+	if (parameters->padding == 0 || data_values > (size_t)-1 - parameters->padding || parameters->padding + data_values > (size_t)-1 / parameters->bytes_per_value)
+		return 0;
+
+	return (parameters->padding + data_values) * parameters->bytes_per_value;
+}
+
+static void InitialisePaddedHead(Parameters* const parameters, unsigned char* const buffer)
+{
+	const size_t padding_bytes = parameters->padding * parameters->bytes_per_value;
+	const size_t data_bytes = GetPaddedHeadSize(parameters) - padding_bytes;
+	size_t i;
+
+	for (i = 0; i < padding_bytes; ++i)
+		buffer[i] = (unsigned char)parameters->filler_value;
+
+	for (i = 0; i < data_bytes; ++i)
+		buffer[padding_bytes + i] = parameters->data[i];
+
+	parameters->padded_head = buffer;
+}
+
+static size_t GetMatchLength(const Parameters* const parameters, const size_t position, const size_t distance, const size_t length, const size_t maximum_length)
+{
+	const size_t bytes_per_value = parameters->bytes_per_value;
+
+	/* The first `length` values are already known to match. Only the earlier string can begin in the filler values. */
+	const unsigned char* const current_bytes = &parameters->data[(position + length) * bytes_per_value];
+	const unsigned char* const match_bytes = GetPaddedBytes(parameters, (parameters->padding + position + length - distance) * bytes_per_value);
+
+	return length + CompareValues(parameters, current_bytes, match_bytes, maximum_length - length);
+}
+
+static int IsMatchUseful(const size_t cost, const size_t length, const size_t literal_cost)
+{
+	/* A match that costs at least as much as the literals that it replaces can never be selected, as
+	   literals win ties. A cost of 0 means that the match cannot be encoded at all. */
+	if (cost == 0)
+		return 0;
+	else if (literal_cost > (size_t)-1 / length)
+		return 1;
+	else
+		return cost < length * literal_cost;
+}
+
+static size_t GetCostTier(const Parameters* const parameters, const size_t distance)
+{
+	size_t tier;
+
+	for (tier = 0; distance > parameters->cost_distance_tiers[tier]; ++tier);
+
+	return tier;
+}
+
+static size_t GetMatchCost(const Parameters* const parameters, const size_t distance, const size_t length)
+{
+	if (parameters->cost_table != NULL && length < parameters->cost_table_width)
+		return parameters->cost_table[GetCostTier(parameters, distance) * parameters->cost_table_width + length];
+	else
+		return parameters->match_cost_callback(distance, length, parameters->user);
+}
+
+static size_t* BuildCostTable(const Parameters* const parameters, const size_t total_distance_tiers, size_t* const table)
+{
+	const size_t* const distance_tiers = parameters->cost_distance_tiers;
+	const size_t width = parameters->cost_table_width;
+	size_t tier;
+
+	/* The tiers must be in order, and must cover the whole window. */
+	if (total_distance_tiers == 0 || distance_tiers[total_distance_tiers - 1] < parameters->maximum_match_distance)
+		return NULL;
+
+	for (tier = 1; tier < total_distance_tiers; ++tier)
+		if (distance_tiers[tier] <= distance_tiers[tier - 1])
+			return NULL;
+
+	for (tier = 0; tier < total_distance_tiers; ++tier)
+	{
+		const size_t nearest_distance = tier == 0 ? 1 : distance_tiers[tier - 1] + 1;
+		const size_t furthest_distance = distance_tiers[tier];
+		size_t* const row = &table[tier * width];
+		size_t length;
+
+		row[0] = 0;
+
+		for (length = 1; length < width; ++length)
+		{
+			row[length] = parameters->match_cost_callback(nearest_distance, length, parameters->user);
+
+			/* Sanity-check the tiers: if the cost changes within one, then they were wrong, so do not use the table. */
+			if (row[length] != parameters->match_cost_callback(furthest_distance, length, parameters->user))
+				return NULL;
+		}
+	}
+
+	return table;
+}
+
+static int IsCostTailConsistent(const Parameters* const parameters, const size_t distance, const size_t period, const size_t step, const size_t longest_length)
+{
+	size_t length;
+
+	/* The table only goes so far, so check the rest of the lengths with the callback. */
+	for (length = parameters->cost_table_width; length <= longest_length; ++length)
+	{
+		const size_t cost = parameters->match_cost_callback(distance, length, parameters->user);
+
+		if (cost == 0 || cost != GetMatchCost(parameters, distance, length - period) + step)
+			return 0;
+	}
+
+	return 1;
+}
+
+static void FindCostTail(Parameters* const parameters, const size_t total_distance_tiers)
+{
+	const size_t width = parameters->cost_table_width;
+	const size_t longest_length = CLOWNLZSS_MIN(parameters->maximum_match_length, parameters->total_values);
+	size_t period, tier;
+
+	parameters->cost_tail_period = 0;
+
+	/* Making use of the tail relies on every earlier position having relaxed all of its matches. */
+	if (parameters->cost_table == NULL || parameters->parser != CLOWNLZSS_PARSER_OPTIMAL || parameters->descriptor_field_bits != 0 || parameters->maximum_chain_length != (size_t)-1
+	 || parameters->nice_match_length != (size_t)-1 || parameters->good_match_length != (size_t)-1)
+		return;
+
+	/* Usually, long matches either all cost the same, or cost a little more every so many values. Find the
+	   period that every tier has in common, and that begins at the shortest length. */
+	for (period = 1; period <= CLOWNLZSS_MAXIMUM_COST_TAIL_PERIOD && period + 1 < width; ++period)
+	{
+		const size_t step = parameters->cost_table[width - 1] - parameters->cost_table[width - 1 - period];
+		size_t tail_length = 0;
+
+		for (tier = 0; tier < total_distance_tiers; ++tier)
+		{
+			const size_t* const row = &parameters->cost_table[tier * width];
+			size_t length;
+
+			if (row[width - 1] < row[width - 1 - period] || row[width - 1] - row[width - 1 - period] != step)
+				break;
+
+			for (length = width - 1 - period; length != 0 && row[length] != 0 && row[length + period] == row[length] + step; --length);
+
+			tail_length = CLOWNLZSS_MAX(tail_length, length + 1);
+		}
+
+		if (tier == total_distance_tiers && tail_length + period < width && (parameters->cost_tail_period == 0 || tail_length < parameters->cost_tail_length))
+		{
+			parameters->cost_tail_length = tail_length;
+			parameters->cost_tail_period = period;
+			parameters->cost_tail_step = step;
+		}
+	}
+
+	/* Like the table, the tail is only checked at either end of each tier. */
+	if (parameters->cost_tail_period != 0)
+	{
+		for (tier = 0; tier < total_distance_tiers; ++tier)
+		{
+			const size_t nearest_distance = tier == 0 ? 1 : parameters->cost_distance_tiers[tier - 1] + 1;
+
+			if (!IsCostTailConsistent(parameters, nearest_distance, parameters->cost_tail_period, parameters->cost_tail_step, longest_length)
+			 || !IsCostTailConsistent(parameters, parameters->cost_distance_tiers[tier], parameters->cost_tail_period, parameters->cost_tail_step, longest_length))
+			{
+				parameters->cost_tail_period = 0;
+				break;
+			}
+		}
+	}
+}
+
+static size_t GetMinimumUsefulMatchLength(const Parameters* const parameters, const size_t maximum_length)
+{
+	size_t length;
+
+	/* Find the shortest match length that could ever appear in the shortest path. Anything shorter than
+	   this does not need to be found, so it does not need to be part of the hash-chain key either. */
+	for (length = 1; length < maximum_length && length < parameters->maximum_match_length; ++length)
+	{
+		size_t distance;
+
+		for (distance = 1; distance <= parameters->maximum_match_distance; ++distance)
+			if (IsMatchUseful(GetMatchCost(parameters, distance, length), length, parameters->literal_cost))
+				return length;
+	}
+
+	return length;
+}
+
+static void RelaxEdge(ClownLZSS_GraphEdge* const node_meta_array, const size_t position, const size_t length, const size_t cost, const size_t match_offset)
+{
+	/* Figure out if the cost is lower than that of any other runs that end at the same value as this one */
+	if (cost != 0 && node_meta_array[position + length].u.cost > node_meta_array[position].u.cost + cost)
+	{
+		/* Record this new best run in the graph edge assigned to the value at the end of the run */
+		node_meta_array[position + length].u.cost = node_meta_array[position].u.cost + cost;
+		node_meta_array[position + length].previous_node_index = position;
+		node_meta_array[position + length].match_offset = match_offset;
+	}
+}
+
+static void RelaxCompactEdge(CompactGraphEdge* const graph, const size_t position, const size_t length, const size_t cost, const size_t match_offset)
+{
+	/* The same as above. Only a cost that is lower than the old one is stored, so it always fits. */
+	if (cost != 0 && graph[position + length].u.cost > graph[position].u.cost + cost)
+	{
+		graph[position + length].u.cost = (ClownLZSS_Link)(graph[position].u.cost + cost);
+		graph[position + length].previous_node_index = (ClownLZSS_Link)position;
+		graph[position + length].match_offset = (ClownLZSS_Link)match_offset;
+	}
+}
+
+static void RelaxRepeatingEdge(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, const size_t position, const size_t length, const size_t cost, const size_t match_offset, const size_t repeat_distance)
+{
+	/* The same as `RelaxEdge`, except that the distance that the edge leaves behind is recorded too. */
+	if (cost != 0 && node_meta_array[position + length].u.cost > node_meta_array[position].u.cost + cost)
+	{
+		node_meta_array[position + length].u.cost = node_meta_array[position].u.cost + cost;
+		node_meta_array[position + length].previous_node_index = position;
+		node_meta_array[position + length].match_offset = match_offset;
+		parameters->repeats[position + length].source = position;
+		parameters->repeats[position + length].distance = repeat_distance;
+	}
+}
+
+static void RelaxDescriptorEdge(const Parameters* const parameters, const size_t position, const size_t length, const size_t cost, const size_t match_offset, const int wins_ties)
+{
+	/* The same as `RelaxEdge`, except for every fill of the descriptor field at once, with the edge's
+	   descriptor bits being whatever is left over from the bytes. */
+	const size_t field_bits = parameters->descriptor_field_bits;
+	const size_t descriptor_bits = cost % 8;
+	ClownLZSS_GraphEdge* const sources = &parameters->descriptor_graph[position * field_bits];
+	ClownLZSS_GraphEdge* const destinations = &parameters->descriptor_graph[(position + length) * field_bits];
+	size_t fill;
+
+	if (cost == 0)
+		return;
+
+	for (fill = 0; fill < field_bits; ++fill)
+	{
+		ClownLZSS_GraphEdge* const destination = &destinations[(fill + descriptor_bits) % field_bits];
+
+		if (sources[fill].u.cost != CLOWNLZSS_GRAPH_DUMMY
+		 && (destination->u.cost > sources[fill].u.cost + cost || (wins_ties && destination->u.cost == sources[fill].u.cost + cost)))
+		{
+			destination->u.cost = sources[fill].u.cost + cost;
+			destination->previous_node_index = position * field_bits + fill;
+			destination->match_offset = match_offset;
+		}
+	}
+}
+
+/* These relax the nodes that a match reaches for every length from `minimum_length` to `maximum_length`,
+   with the cost of each length coming from `costs`, which is indexed by length. */
+
+static void RelaxRange(ClownLZSS_GraphEdge* const node_meta_array, const size_t position, const size_t minimum_length, const size_t maximum_length, const size_t* const costs, const size_t match_offset)
+{
+	size_t length;
+
+	for (length = minimum_length; length <= maximum_length; ++length)
+		RelaxEdge(node_meta_array, position, length, costs[length], match_offset);
+}
+
+static void RelaxCompactRange(ClownLZSS_GraphEdge* const node_meta_array, const size_t position, const size_t minimum_length, const size_t maximum_length, const size_t* const costs, const size_t match_offset)
+{
+	size_t length;
+
+	for (length = minimum_length; length <= maximum_length; ++length)
+		RelaxCompactEdge((CompactGraphEdge*)node_meta_array, position, length, costs[length], match_offset);
+}
+
+static size_t GetNodeCost(const Parameters* const parameters, const ClownLZSS_GraphEdge* const node_meta_array, const size_t position)
+{
+	if (parameters->compact_graph)
+	{
+		const ClownLZSS_Link cost = ((const CompactGraphEdge*)node_meta_array)[position].u.cost;
+
+		return cost == CLOWNLZSS_LINK_NONE ? CLOWNLZSS_GRAPH_DUMMY : cost;
+	}
+	else if (parameters->descriptor_graph != NULL)
+	{
+		const ClownLZSS_GraphEdge* const nodes = &parameters->descriptor_graph[position * parameters->descriptor_field_bits];
+		size_t cost, fill;
+
+		cost = CLOWNLZSS_GRAPH_DUMMY;
+
+		for (fill = 0; fill < parameters->descriptor_field_bits; ++fill)
+			cost = CLOWNLZSS_MIN(cost, nodes[fill].u.cost);
+
+		return cost;
+	}
+	else
+	{
+		return node_meta_array[position].u.cost;
+	}
+}
+
+static void RelaxMatchLengths(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, const size_t position, const size_t distance, const size_t minimum_length, const size_t maximum_length)
+{
+	size_t length;
+
+	length = minimum_length;
+
+	/* The batched relaxation cannot record the distances, so do it one length at a time. */
+	if (parameters->repeats != NULL)
+	{
+		for (; length <= maximum_length; ++length)
+			RelaxRepeatingEdge(parameters, node_meta_array, position, length, GetMatchCost(parameters, distance, length), position - distance, distance);
+
+		return;
+	}
+
+	if (parameters->descriptor_graph != NULL)
+	{
+		for (; length <= maximum_length; ++length)
+			RelaxDescriptorEdge(parameters, position, length, GetMatchCost(parameters, distance, length), position - distance, 0);
+
+		return;
+	}
+
+	/* Figure out how much it costs to encode the current run, using the table where possible. */
+	if (parameters->cost_table != NULL)
+	{
+		const size_t* const costs = &parameters->cost_table[GetCostTier(parameters, distance) * parameters->cost_table_width];
+		const size_t tabulated_maximum_length = CLOWNLZSS_MIN(maximum_length, parameters->cost_table_width - 1);
+
+		if (length <= tabulated_maximum_length)
+		{
+			if (parameters->compact_graph)
+				RelaxCompactRange(node_meta_array, position, length, tabulated_maximum_length, costs, position - distance);
+			else
+				RelaxRange(node_meta_array, position, length, tabulated_maximum_length, costs, position - distance);
+
+			length = tabulated_maximum_length + 1;
+		}
+	}
+
+	for (; length <= maximum_length; ++length)
+	{
+		const size_t cost = parameters->match_cost_callback(distance, length, parameters->user);
+
+		if (parameters->compact_graph)
+			RelaxCompactEdge((CompactGraphEdge*)node_meta_array, position, length, cost, position - distance);
+		else
+			RelaxEdge(node_meta_array, position, length, cost, position - distance);
+	}
+}
+
+static void RelaxMatch(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, const size_t position, const size_t distance, const size_t minimum_length, const size_t maximum_length)
+{
+	const size_t period = parameters->cost_tail_period;
+
+	if (parameters->cut_points != NULL)
+		parameters->cut_points->furthest_edge = CLOWNLZSS_MAX(parameters->cut_points->furthest_edge, position + maximum_length);
+
+	/* If the same match began `period` values earlier, then it reached every node that this one does, and the lengths in the
+	   tail cost exactly `step` more from there. So, unless this position is that much cheaper, those lengths cannot improve
+	   anything, and ties go to the earlier match anyway. In runs and repeating data, this leaves very few lengths to relax. */
+	if (period != 0 && position >= parameters->history + period && distance <= position - period + parameters->padding)
+	{
+		const size_t earlier_position = position - period;
+		const size_t earlier_length = CLOWNLZSS_MIN(period + maximum_length, CLOWNLZSS_MIN(parameters->maximum_match_length, parameters->total_values - earlier_position));
+		const size_t first_redundant_length = CLOWNLZSS_MAX(minimum_length, parameters->cost_tail_length);
+		const size_t last_redundant_length = CLOWNLZSS_MIN(maximum_length, earlier_length - period);
+		const size_t earlier_cost = GetNodeCost(parameters, node_meta_array, earlier_position);
+
+		if (first_redundant_length <= last_redundant_length && earlier_cost != CLOWNLZSS_GRAPH_DUMMY
+		 && earlier_cost + parameters->cost_tail_step <= GetNodeCost(parameters, node_meta_array, position)
+		 && GetMatchLength(parameters, earlier_position, distance, 0, period) == period)
+		{
+			RelaxMatchLengths(parameters, node_meta_array, position, distance, minimum_length, first_redundant_length - 1);
+			RelaxMatchLengths(parameters, node_meta_array, position, distance, last_redundant_length + 1, maximum_length);
+			return;
+		}
+	}
+
+	RelaxMatchLengths(parameters, node_meta_array, position, distance, minimum_length, maximum_length);
+}
+
+static size_t GetLiteralRunCost(const LiteralRuns* const literal_runs, const size_t tier, const size_t length)
+{
+	return literal_runs->header_costs[tier] + literal_runs->value_cost * length;
+}
+
+static void ResolveLiteralRuns(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, const size_t node)
+{
+	LiteralRuns* const literal_runs = parameters->literal_runs;
+	const size_t capacity = literal_runs != NULL ? literal_runs->capacity : 0;
+	size_t best_cost, best_source, tier;
+
+	/* Every source before the node must have been visited, and every other edge to the node relaxed, except for the literal. */
+	if (literal_runs == NULL || !literal_runs->deferred || node <= literal_runs->resolved_node)
+		return;
+
+	literal_runs->resolved_node = node;
+
+	best_cost = CLOWNLZSS_GRAPH_DUMMY;
+	best_source = CLOWNLZSS_GRAPH_DUMMY;
+
+	for (tier = 0; tier < literal_runs->total_tiers; ++tier)
+	{
+		const size_t shortest_length = tier == 0 ? 1 : literal_runs->length_tiers[tier - 1] + 1;
+		const size_t longest_length = literal_runs->length_tiers[tier];
+		size_t* const queue = &literal_runs->queues[tier * capacity];
+		size_t* const queue_start = &literal_runs->queue_starts[tier];
+		size_t* const queue_length = &literal_runs->queue_lengths[tier];
+		size_t* const joined_sources = &literal_runs->joined_sources[tier];
+
+		/* Drop the sources that are too far away for this tier's header. */
+		while (*queue_length != 0 && node - queue[*queue_start] > longest_length)
+		{
+			*queue_start = (*queue_start + 1) % capacity;
+			--*queue_length;
+		}
+
+		/* Add the sources that are now far enough away to need it. */
+		for (; *joined_sources != literal_runs->total_sources; ++*joined_sources)
+		{
+			const size_t source = literal_runs->sources[*joined_sources % capacity];
+
+			if (node - source < shortest_length)
+				break;
+
+			if (node - source > longest_length)
+				continue;
+
+			/* An earlier source that is no cheaper than this one at the same length will never be cheaper again, as it
+			   leaves the tier first. Equal sources are kept, as the earlier one wins the tie while it lasts. */
+			while (*queue_length != 0)
+			{
+				const size_t last_source = queue[(*queue_start + *queue_length - 1) % capacity];
+
+				if (node_meta_array[source].u.cost >= node_meta_array[last_source].u.cost + literal_runs->value_cost * (source - last_source))
+					break;
+
+				--*queue_length;
+			}
+
+			queue[(*queue_start + *queue_length) % capacity] = source;
+			++*queue_length;
+		}
+
+		if (*queue_length != 0)
+		{
+			const size_t source = queue[*queue_start];
+			const size_t cost = node_meta_array[source].u.cost + GetLiteralRunCost(literal_runs, tier, node - source);
+
+			if (cost < best_cost || (cost == best_cost && source < best_source))
+			{
+				best_cost = cost;
+				best_source = source;
+			}
+		}
+	}
+
+	/* Use the run if it would have won had it been relaxed along with everything else: edges from earlier sources win
+	   ties, and, from the same source, only an extra match can tie with it, which would have been relaxed first. */
+	if (best_source != CLOWNLZSS_GRAPH_DUMMY && (best_cost < node_meta_array[node].u.cost || (best_cost == node_meta_array[node].u.cost && best_source < node_meta_array[node].previous_node_index)))
+	{
+		node_meta_array[node].u.cost = best_cost;
+		node_meta_array[node].previous_node_index = best_source;
+		node_meta_array[node].match_offset = best_source;
+
+		if (parameters->repeats != NULL)
+		{
+			parameters->repeats[node].source = best_source;
+			parameters->repeats[node].distance = parameters->repeats[best_source].distance;
+		}
+	}
+}
+
+static void VisitLiteralRuns(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, const size_t position)
+{
+	LiteralRuns* const literal_runs = parameters->literal_runs;
+	size_t longest_length;
+
+	if (literal_runs == NULL || node_meta_array[position].u.cost == CLOWNLZSS_GRAPH_DUMMY)
+		return;
+
+	longest_length = CLOWNLZSS_MIN(literal_runs->length_tiers[literal_runs->total_tiers - 1], parameters->total_values - position);
+
+	if (parameters->cut_points != NULL)
+		parameters->cut_points->furthest_edge = CLOWNLZSS_MAX(parameters->cut_points->furthest_edge, position + longest_length);
+
+	if (literal_runs->deferred)
+	{
+		literal_runs->sources[literal_runs->total_sources % literal_runs->capacity] = position;
+		++literal_runs->total_sources;
+	}
+	else
+	{
+		size_t tier, length;
+
+		tier = 0;
+
+		for (length = 1; length <= longest_length; ++length)
+		{
+			if (length > literal_runs->length_tiers[tier])
+				++tier;
+
+			if (parameters->repeats != NULL)
+				RelaxRepeatingEdge(parameters, node_meta_array, position, length, GetLiteralRunCost(literal_runs, tier, length), position, parameters->repeats[position].distance);
+			else
+				RelaxEdge(node_meta_array, position, length, GetLiteralRunCost(literal_runs, tier, length), position);
+		}
+	}
+}
+
+static int IsReachedByLiteralRun(const Parameters* const parameters, const size_t node)
+{
+	const LiteralRuns* const literal_runs = parameters->literal_runs;
+
+	/* Deferred runs are not in the graph yet, but no source reaches further than the latest one. */
+	return literal_runs != NULL && literal_runs->deferred && literal_runs->total_sources != 0
+		&& node - literal_runs->sources[(literal_runs->total_sources - 1) % literal_runs->capacity] <= literal_runs->length_tiers[literal_runs->total_tiers - 1];
+}
+
+static size_t GetRepeatDistance(const Parameters* const parameters, const ClownLZSS_GraphEdge* const node_meta_array, const size_t node)
+{
+	RepeatEdge* const repeat = &parameters->repeats[node];
+
+	/* An edge from the extra matches callback leaves the distance as it was. */
+	if (repeat->source != node_meta_array[node].previous_node_index)
+	{
+		repeat->source = node_meta_array[node].previous_node_index;
+		repeat->distance = parameters->repeats[repeat->source].distance;
+	}
+
+	return repeat->distance;
+}
+
+static void VisitRepeatMatches(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, const size_t position)
+{
+	size_t distance, longest_length, length;
+
+	if (parameters->repeats == NULL || node_meta_array[position].u.cost == CLOWNLZSS_GRAPH_DUMMY)
+		return;
+
+	distance = GetRepeatDistance(parameters, node_meta_array, position);
+
+	if (distance == 0)
+		return;
+
+	longest_length = GetMatchLength(parameters, position, distance, 0, CLOWNLZSS_MIN(parameters->maximum_repeat_match_length, parameters->total_values - position));
+
+	if (parameters->cut_points != NULL)
+		parameters->cut_points->furthest_edge = CLOWNLZSS_MAX(parameters->cut_points->furthest_edge, position + longest_length);
+
+	for (length = 1; length <= longest_length; ++length)
+		RelaxRepeatingEdge(parameters, node_meta_array, position, length, parameters->repeat_match_cost, position - distance, distance);
+}
+
+static void VisitHints(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, const size_t position)
+{
+	const size_t bytes_per_value = parameters->bytes_per_value;
+	const size_t maximum_length = CLOWNLZSS_MIN(parameters->total_values - position, parameters->maximum_match_length);
+	HintCursor* const cursor = parameters->hint_cursor;
+	size_t distances[CLOWNLZSS_TOTAL_RECENT_HINT_DISTANCES];
+	size_t longest_length, i, j;
+
+	if (parameters->hints == NULL)
+		return;
+
+	/* Hints that were skipped over, such as by a long match, still leave their distances behind. */
+	for (; cursor->next_hint < parameters->total_hints && parameters->hints[cursor->next_hint].destination <= position * bytes_per_value; ++cursor->next_hint)
+	{
+		const ClownLZSS_Match* const hint = &parameters->hints[cursor->next_hint];
+
+		/* The hints are in bytes, so ones that do not line up with the values are useless. */
+		if (hint->source < hint->destination && hint->destination % bytes_per_value == 0 && hint->source % bytes_per_value == 0
+		 && (hint->destination - hint->source) / bytes_per_value <= parameters->maximum_match_distance)
+		{
+			const size_t distance = (hint->destination - hint->source) / bytes_per_value;
+
+			/* Move the distance to the front, dropping the least recent one if it is new. */
+			for (i = 0; i < CLOWNLZSS_TOTAL_RECENT_HINT_DISTANCES - 1 && cursor->recent_distances[i] != distance; ++i);
+
+			for (; i != 0; --i)
+				cursor->recent_distances[i] = cursor->recent_distances[i - 1];
+
+			cursor->recent_distances[0] = distance;
+		}
+	}
+
+	/* Like the match finders, try the nearest distances first, so that each one only has to relax the lengths that the ones
+	   before it could not reach. */
+	for (i = 0; i < CLOWNLZSS_TOTAL_RECENT_HINT_DISTANCES; ++i)
+	{
+		const size_t distance = cursor->recent_distances[i];
+
+		for (j = i; j != 0 && distances[j - 1] > distance; --j)
+			distances[j] = distances[j - 1];
+
+		distances[j] = distance;
+	}
+
+	longest_length = parameters->minimum_match_length - 1;
+
+	for (i = 0; i < CLOWNLZSS_TOTAL_RECENT_HINT_DISTANCES && longest_length < maximum_length; ++i)
+	{
+		/* The hints may have come from anywhere, so check that they really match. */
+		if (distances[i] != 0 && distances[i] <= position && (i == 0 || distances[i] != distances[i - 1]))
+		{
+			const size_t length = GetMatchLength(parameters, position, distances[i], 0, maximum_length);
+
+			if (length > longest_length)
+			{
+				RelaxMatch(parameters, node_meta_array, position, distances[i], longest_length + 1, length);
+				longest_length = length;
+			}
+		}
+	}
+}
+
+static int HasExtraMatches(const Parameters* const parameters)
+{
+	return parameters->extra_matches_callback != NULL || parameters->extra_run_matches_callback != NULL;
+}
+
+static void VisitPosition(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, const size_t position)
+{
+	CutPoints* const cut_points = parameters->cut_points;
+
+	ResolveLiteralRuns(parameters, node_meta_array, position);
+
+	if (cut_points != NULL)
+	{
+		/* If no edge reaches past this position, then every path passes through it. */
+		if (cut_points->furthest_edge <= position)
+			cut_points->last_cut_point = position;
+
+		/* The literal. */
+		cut_points->furthest_edge = CLOWNLZSS_MAX(cut_points->furthest_edge, position + 1);
+	}
+
+	if (HasExtraMatches(parameters))
+	{
+		/* With the descriptor graph, the callback relaxes an empty stretch of the ordinary graph instead,
+		   and its edges are moved over to every fill of the field afterwards. */
+		if (parameters->descriptor_graph != NULL)
+			node_meta_array[position].u.cost = 0;
+
+		if (parameters->extra_run_matches_callback != NULL)
+		{
+			/* A value is in the same run as the one before it if they match at a distance of 1. */
+			if (position >= *parameters->run_end)
+				*parameters->run_end = position + 1 + (position + 1 < parameters->total_values ? GetMatchLength(parameters, position + 1, 1, 0, parameters->total_values - position - 1) : 0);
+
+			parameters->extra_run_matches_callback(parameters->data, parameters->total_values, position, *parameters->run_end - position, node_meta_array, parameters->user);
+		}
+		else
+		{
+			parameters->extra_matches_callback(parameters->data, parameters->total_values, position, node_meta_array, parameters->user);
+		}
+
+		if (parameters->descriptor_graph != NULL)
+		{
+			size_t i;
+
+			for (i = position + 1; i <= CLOWNLZSS_MIN(position + parameters->maximum_extra_match_length, parameters->total_values); ++i)
+			{
+				if (node_meta_array[i].u.cost != CLOWNLZSS_GRAPH_DUMMY)
+				{
+					RelaxDescriptorEdge(parameters, position, i - position, node_meta_array[i].u.cost, node_meta_array[i].match_offset, 0);
+					node_meta_array[i].u.cost = CLOWNLZSS_GRAPH_DUMMY;
+				}
+			}
+		}
+
+		/* The callback relaxes the nodes by itself, so look for the furthest one that it reached. */
+		if (cut_points != NULL)
+		{
+			size_t i;
+
+			for (i = CLOWNLZSS_MIN(position + parameters->maximum_extra_match_length, parameters->total_values); i > cut_points->furthest_edge; --i)
+			{
+				if (node_meta_array[i].u.cost != CLOWNLZSS_GRAPH_DUMMY)
+				{
+					cut_points->furthest_edge = i;
+					break;
+				}
+			}
+		}
+	}
+
+	/* These come before the literal runs, so that, like the extra matches, they win ties with them. */
+	VisitRepeatMatches(parameters, node_meta_array, position);
+	VisitLiteralRuns(parameters, node_meta_array, position);
+	VisitHints(parameters, node_meta_array, position);
+}
+
+static void RelaxLiteral(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, const size_t position)
+{
+	/* The literal is the last edge to reach the next node, and it wins ties, so the runs have to be in place before it. */
+	ResolveLiteralRuns(parameters, node_meta_array, position + 1);
+
+	if (parameters->descriptor_graph != NULL)
+	{
+		RelaxDescriptorEdge(parameters, position, 1, parameters->literal_cost, position + 1, 1);
+	}
+	else if (parameters->compact_graph)
+	{
+		CompactGraphEdge* const graph = (CompactGraphEdge*)node_meta_array;
+
+		if (graph[position + 1].u.cost >= graph[position].u.cost + parameters->literal_cost)
+		{
+			graph[position + 1].u.cost = (ClownLZSS_Link)(graph[position].u.cost + parameters->literal_cost);
+			graph[position + 1].previous_node_index = (ClownLZSS_Link)position;
+			graph[position + 1].match_offset = (ClownLZSS_Link)(position + 1);
+		}
+	}
+	/* If a literal match is more efficient than all runs assigned to this value, then use that instead */
+	else if (node_meta_array[position + 1].u.cost >= node_meta_array[position].u.cost + parameters->literal_cost)
+	{
+		node_meta_array[position + 1].u.cost = node_meta_array[position].u.cost + parameters->literal_cost;
+		node_meta_array[position + 1].previous_node_index = position;
+		node_meta_array[position + 1].match_offset = position + 1;
+
+		if (parameters->repeats != NULL)
+		{
+			parameters->repeats[position + 1].source = position;
+			parameters->repeats[position + 1].distance = parameters->repeats[position].distance;
+		}
+	}
+}
+
+static size_t GetNextParsedPosition(const Parameters* const parameters, const ClownLZSS_GraphEdge* const node_meta_array, const size_t position, const size_t longest_match_length)
+{
+	/* If the longest match is good enough, then take it without parsing the positions that it covers,
+	   as long as that does not leave the end of the parse unreachable. */
+	if (longest_match_length >= parameters->good_match_length && position + longest_match_length <= parameters->parse_end
+	 && (GetNodeCost(parameters, node_meta_array, position + longest_match_length) != CLOWNLZSS_GRAPH_DUMMY || IsReachedByLiteralRun(parameters, position + longest_match_length)))
+		return position + longest_match_length;
+	else
+		return position + 1;
+}
+
+/********\
+* Fields *
+\********/
+
+/* Checkpoints and candidates are made of little-endian numbers of a fixed size, so that they do not depend on the size of
+   `size_t`, after an eight-byte magic number. They are given to a callback a chunk at a time. */
+
+#define CLOWNLZSS_MAGIC_BYTES 8
+#define CLOWNLZSS_FIELD_WRITER_BYTES 0x300
+/* The fields of the candidates are only positions and lengths, which the links already limit to 32 bits. */
+#define CLOWNLZSS_CANDIDATE_FIELD_BYTES 4
+
+typedef struct FieldWriter
+{
+	void (*write)(const unsigned char *bytes, size_t total_bytes, void *user);
+	void *user;
+	unsigned char buffer[CLOWNLZSS_FIELD_WRITER_BYTES];
+	size_t total_bytes;
+} FieldWriter;
+
+static void InitialiseFieldWriter(FieldWriter* const writer, void (* const write)(const unsigned char *bytes, size_t total_bytes, void *user), void* const user, const char* const magic)
+{
+	writer->write = write;
+	writer->user = user;
+
+	for (writer->total_bytes = 0; writer->total_bytes < CLOWNLZSS_MAGIC_BYTES; ++writer->total_bytes)
+		writer->buffer[writer->total_bytes] = (unsigned char)magic[writer->total_bytes];
+}
+
+static void FlushFields(FieldWriter* const writer)
+{
+	if (writer->total_bytes != 0)
+		writer->write(writer->buffer, writer->total_bytes, writer->user);
+
+	writer->total_bytes = 0;
+}
+
+static void PutField(FieldWriter* const writer, size_t value, const unsigned int total_bytes)
+{
+	unsigned int i;
+
+	if (writer->total_bytes + total_bytes > sizeof(writer->buffer))
+		FlushFields(writer);
+
+	for (i = 0; i < total_bytes; ++i)
+	{
+		writer->buffer[writer->total_bytes++] = (unsigned char)(value & 0xFF);
+		/* Shifted twice, as shifting by the full width of a 32-bit `size_t` would be undefined. */
+		value = value >> 4 >> 4;
+	}
+}
+
+static int GetField(const unsigned char* const bytes, const unsigned int total_bytes, size_t* const value)
+{
+	unsigned int i;
+
+	*value = 0;
+
+	/* Fields that are too large for this `size_t` can never be valid. */
+	for (i = total_bytes; i-- != 0; )
+	{
+		if (i >= sizeof(size_t) && bytes[i] != 0)
+			return 0;
+
+		*value = *value << 4 << 4 | bytes[i];
+	}
+
+	return 1;
+}
+
+/******************\
+* Hash-chain finder *
+\******************/
+
+static unsigned int GetHashBits(const size_t key_bytes, const size_t bytes_per_value, const size_t maximum_match_distance)
+{
+	unsigned int bits;
+
+	/* A single byte can be used as the hash directly. */
+	if (key_bytes == 1)
+		return 8;
+
+	/* Words have far more possible keys than a window has positions, and data that is made of them, such as tiles and
+	   palettes, shares so many of its bytes that the keys crowd into few buckets, so give them as many as possible.
+	   This is enough for a single word to be used as the hash directly too. */
+	if (bytes_per_value != 1)
+		return CLOWNLZSS_MAXIMUM_HASH_BITS;
+
+	/* Aim for roughly two buckets per window position. */
+	for (bits = CLOWNLZSS_MINIMUM_HASH_BITS; bits < CLOWNLZSS_MAXIMUM_HASH_BITS && ((size_t)1 << bits) < maximum_match_distance * 2; ++bits);
+
+	return bits;
+}
+
+static int PaddedValuesEqual(const Parameters* const parameters, const size_t a, const size_t b)
+{
+	const size_t bytes_per_value = parameters->bytes_per_value;
+
+	return ValuesEqual(GetPaddedBytes(parameters, a * bytes_per_value), GetPaddedBytes(parameters, b * bytes_per_value), bytes_per_value);
+}
+
+static size_t GetHash(const Parameters* const parameters, const size_t padded_position, const size_t key_bytes, const unsigned int hash_bits)
+{
+	const unsigned char* const bytes = GetPaddedBytes(parameters, padded_position * parameters->bytes_per_value);
+	unsigned long key;
+	size_t i;
+
+	key = 0;
+
+	for (i = 0; i < key_bytes; ++i)
+		key = (key << 8) | bytes[i];
+
+	if (hash_bits == key_bytes * 8)
+		return key;
+	else
+		return ((key * 0x9E3779B1UL) & 0xFFFFFFFFUL) >> (32 - hash_bits);
+}
+
+static size_t GetFirstLinkedValue(const Parameters* const parameters)
+{
+	/* Strings more than a window before the parse can never be matched, and the links of the ones in the window only
+	   depend on the window before them, so a parse that resumes part-way through the data can skip the rest. */
+	const size_t first_parsed_value = parameters->padding + parameters->history;
+	const size_t window_start = first_parsed_value - CLOWNLZSS_MIN(first_parsed_value, parameters->maximum_match_distance);
+
+	return window_start - CLOWNLZSS_MIN(window_start, parameters->maximum_match_distance);
+}
+
+typedef struct HashChainSearch
+{
+	/* The links of the hash-chains (see `FindMatchesHashChain`), indexed by padded position modulo `link_modulus`. */
+	const ClownLZSS_Link *links;
+	const ClownLZSS_Link *run_links;
+	size_t link_modulus;
+	/* The longest match of the last position that was searched. */
+	size_t previous_position;
+	size_t previous_distance;
+	size_t previous_length;
+	/* How many values before the current one are the same as it. */
+	size_t run_length;
+	/* If not NULL, then the matches are recorded here instead of being relaxed. The ones that do not fit are still
+	   counted, so, if there are more than `found_matches_capacity` of them, then the search has run out of room. */
+	FoundMatch *found_matches;
+	size_t total_found_matches;
+	size_t found_matches_capacity;
+} HashChainSearch;
+
+typedef struct HashChainJobs
+{
+	const Parameters *parameters;
+	const ClownLZSS_Link *links;
+	const ClownLZSS_Link *run_links;
+	/* Each job has `CLOWNLZSS_JOB_MATCHES` of these, and records the padded position that it stopped at, in case it ran out. */
+	FoundMatch *found_matches;
+	size_t *searched_ends;
+	/* The padded positions that the jobs start and end at, with each one covering `CLOWNLZSS_JOB_VALUES` of them. */
+	size_t first_value;
+	size_t end_value;
+} HashChainJobs;
+
+static void InitialiseHashChainSearch(HashChainSearch* const search, const ClownLZSS_Link* const links, const ClownLZSS_Link* const run_links, const size_t link_modulus, FoundMatch* const found_matches, const size_t found_matches_capacity)
+{
+	search->links = links;
+	search->run_links = run_links;
+	search->link_modulus = link_modulus;
+	search->previous_position = 0;
+	search->previous_distance = 0;
+	search->previous_length = 0;
+	search->run_length = 0;
+	search->found_matches = found_matches;
+	search->total_found_matches = 0;
+	search->found_matches_capacity = found_matches_capacity;
+}
+
+static void RecordMatch(HashChainSearch* const search, const size_t distance, const size_t minimum_length, const size_t maximum_length)
+{
+	if (search->total_found_matches < search->found_matches_capacity)
+	{
+		FoundMatch* const match = &search->found_matches[search->total_found_matches];
+
+		match->distance = distance;
+		match->minimum_length = minimum_length;
+		match->maximum_length = maximum_length;
+	}
+
+	++search->total_found_matches;
+}
+
+static void LinkHashChain(size_t* const heads, ClownLZSS_Link* const links, ClownLZSS_Link* const run_links, const size_t link_modulus, const size_t maximum_match_distance, const size_t padded_position, const size_t hash)
+{
+	/* Add the string to the start of its hash-chain. In a ring of links, this overwrites the link of the string that
+	   is `maximum_match_distance` values behind it, but that string has just left the LZSS sliding window. */
+	const size_t DUMMY = -1;
+	const size_t i = padded_position;
+	const ClownLZSS_Link link = heads[hash] != DUMMY && i - heads[hash] <= maximum_match_distance ? (ClownLZSS_Link)(i - heads[hash]) : 0;
+	const ClownLZSS_Link previous_run_link = link == 1 ? run_links[(i - 1) % link_modulus] : 0;
+
+	links[i % link_modulus] = link;
+
+	if (link != 1)
+		run_links[i % link_modulus] = link;
+	else if (previous_run_link != 0 && previous_run_link < maximum_match_distance)
+		run_links[i % link_modulus] = previous_run_link + 1;
+	else
+		run_links[i % link_modulus] = 0;
+
+	heads[hash] = i;
+}
+
+static size_t SearchHashChain(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, HashChainSearch* const search, const size_t padded_position, const size_t first_string)
+{
+	const size_t maximum_match_distance = parameters->maximum_match_distance;
+	const size_t key_values = parameters->minimum_match_length;
+	const size_t i = padded_position;
+	const size_t position = i - parameters->padding;
+
+	const size_t DUMMY = -1;
+	size_t longest_match_length = 0, longest_match_distance = 0;
+
+	/* `first_string` begins a chain of strings in the LZSS sliding window that may match at least `key_values`
+	   values with the current string: iterate over it and generate every possible match for this string.
+	   The chains are ordered from nearest to furthest, which matters for deciding between matches of equal cost. */
+	if (parameters->maximum_match_length >= key_values)
+	{
+		const size_t maximum_length = CLOWNLZSS_MIN(parameters->maximum_match_length, parameters->total_values - position);
+		size_t match_string;
+		size_t chain_length = 0;
+		size_t tier = 0;
+		size_t tier_longest_length = 0;
+		size_t last_probed_useless_distance = 0;
+
+		for (match_string = first_string; match_string != DUMMY && i - match_string <= maximum_match_distance; )
+		{
+			ClownLZSS_Link link;
+
+			const size_t distance = i - match_string;
+			const unsigned char* const end_bytes = &parameters->data[(position + tier_longest_length) * parameters->bytes_per_value];
+			size_t length;
+
+			/* Every match in a distance tier has the same costs, and the nearest one wins ties, so a further match in the
+			   same tier only matters for the lengths that the nearer ones did not reach. Without the tiers, every distance
+			   is its own tier. */
+			if (parameters->cost_table == NULL)
+				tier_longest_length = 0;
+			else
+				for (; distance > parameters->cost_distance_tiers[tier]; ++tier)
+					tier_longest_length = 0;
+
+			/* Such a match must at least have the value after the longest one, so check that before comparing the rest. */
+			if (tier_longest_length != 0 && distance <= position && (tier_longest_length == maximum_length || !ValuesEqual(end_bytes, end_bytes - distance * parameters->bytes_per_value, parameters->bytes_per_value)))
+				length = 0;
+			/* The longest match of an earlier position still covers part of this one at the same distance,
+			   so that much does not need comparing again. In a run, that is all of it. */
+			else if (distance == search->previous_distance && search->previous_length > position - search->previous_position)
+				length = GetMatchLength(parameters, position, distance, search->previous_length - (position - search->previous_position), maximum_length);
+			else
+				length = GetMatchLength(parameters, position, distance, 0, maximum_length);
+
+			/* Matches that are shorter than the key are never useful, and are likely just hash collisions.
+			   The table only covers the shorter lengths, so the tiers say nothing about the longer ones. */
+			if (length >= key_values && length > tier_longest_length)
+			{
+				const size_t minimum_length = CLOWNLZSS_MAX(CLOWNLZSS_MIN(tier_longest_length, parameters->cost_table_width - 1) + 1, key_values);
+
+				if (search->found_matches != NULL)
+					RecordMatch(search, distance, minimum_length, length);
+				else
+					RelaxMatch(parameters, node_meta_array, position, distance, minimum_length, length);
+
+				tier_longest_length = length;
+
+				if (length > longest_match_length)
+				{
+					longest_match_length = length;
+					longest_match_distance = distance;
+				}
+			}
+
+			link = search->links[match_string % search->link_modulus];
+
+			/* Stop early if the match is long enough, or if enough of the chain has been searched.
+			   Likewise if the last tier already has the longest possible match, as nothing further can add to it. */
+			if (link == 0 || length >= parameters->nice_match_length || ++chain_length == parameters->maximum_chain_length
+			 || (parameters->cost_table != NULL && parameters->cost_distance_tiers[tier] >= maximum_match_distance && tier_longest_length == maximum_length))
+				break;
+
+			/* Likewise for the rest of any other tier. The same is true of a run that this string is in: every string in it
+			   matches exactly as far as this one, up to the end of the run or the longest possible match. Either way, skip the
+			   strings that cannot add anything. `run_links` skips a run at once, and a full tier usually continues into the next
+			   one, so the string at the start of that is checked directly. This would change which strings a limited chain
+			   reaches, so it is only done without a limit. */
+			if (parameters->cost_table != NULL && parameters->maximum_chain_length == (size_t)-1)
+			{
+				const size_t tier_end = parameters->cost_distance_tiers[tier];
+				const size_t last_useless_distance = tier_longest_length == maximum_length ? tier_end : distance <= search->run_length ? CLOWNLZSS_MIN(tier_end, search->run_length) : 0;
+
+				if (last_useless_distance >= maximum_match_distance)
+					break;
+
+				if (distance + link <= last_useless_distance)
+				{
+					const size_t run_link = search->run_links[match_string % search->link_modulus];
+
+					if (run_link > link && distance + run_link - 1 <= last_useless_distance)
+					{
+						match_string -= run_link;
+						continue;
+					}
+
+					/* Anything with a different key is a hash collision, which is no use either. */
+					if (last_useless_distance != last_probed_useless_distance)
+					{
+						const size_t last_probed_distance = CLOWNLZSS_MIN(last_useless_distance + CLOWNLZSS_SKIP_PROBES, CLOWNLZSS_MIN(i, maximum_match_distance));
+						size_t probed_distance;
+
+						last_probed_useless_distance = last_useless_distance;
+
+						for (probed_distance = last_useless_distance + 1; probed_distance <= last_probed_distance; ++probed_distance)
+						{
+							if (GetMatchLength(parameters, position, probed_distance, 0, key_values) == key_values)
+							{
+								match_string = i - probed_distance;
+								break;
+							}
+						}
+
+						if (probed_distance <= last_probed_distance)
+							continue;
+					}
+				}
+			}
+
+			match_string -= link;
+		}
+	}
+
+	search->previous_position = position;
+	search->previous_distance = longest_match_distance;
+	search->previous_length = longest_match_length;
+
+	return longest_match_length;
+}
+
+static size_t GetFirstLinkedString(const HashChainSearch* const search, const size_t padded_position)
+{
+	/* With every link kept, the start of the chain is just the string that the current one links to. */
+	const ClownLZSS_Link link = search->links[padded_position];
+
+	return link != 0 ? padded_position - link : (size_t)-1;
+}
+
+static size_t GetPaddedRunLength(const Parameters* const parameters, const size_t padded_position)
+{
+	/* The same as counting as the values go by, except that a run that is longer than the window makes no difference. */
+	size_t length;
+
+	for (length = 0; length < padded_position && length < parameters->maximum_match_distance && PaddedValuesEqual(parameters, padded_position - length - 1, padded_position - length); ++length);
+
+	return length;
+}
+
+static void SearchHashChainJob(void* const job_user, const size_t index)
+{
+	HashChainJobs* const jobs = (HashChainJobs*)job_user;
+	const Parameters* const parameters = jobs->parameters;
+	const size_t first_value = jobs->first_value + index * CLOWNLZSS_JOB_VALUES;
+	const size_t end_value = CLOWNLZSS_MIN(first_value + CLOWNLZSS_JOB_VALUES, jobs->end_value);
+
+	HashChainSearch search;
+	size_t i;
+
+	InitialiseHashChainSearch(&search, jobs->links, jobs->run_links, (size_t)-1, &jobs->found_matches[index * CLOWNLZSS_JOB_MATCHES], CLOWNLZSS_JOB_MATCHES);
+
+	/* Each position's matches come after an entry that says how many there are. */
+	for (i = first_value; i < end_value; ++i)
+	{
+		const size_t header = search.total_found_matches;
+		size_t longest_match_length;
+
+		if (i == first_value)
+			search.run_length = GetPaddedRunLength(parameters, i);
+		else if (PaddedValuesEqual(parameters, i - 1, i))
+			++search.run_length;
+		else
+			search.run_length = 0;
+
+		RecordMatch(&search, 0, 0, 0);
+		longest_match_length = SearchHashChain(parameters, NULL, &search, i, GetFirstLinkedString(&search, i));
+
+		/* If there is no room left, then leave the rest of the positions to be searched later. */
+		if (search.total_found_matches > search.found_matches_capacity)
+			break;
+
+		search.found_matches[header].minimum_length = search.total_found_matches - header - 1;
+		search.found_matches[header].maximum_length = longest_match_length;
+	}
+
+	jobs->searched_ends[index] = i;
+}
+
+static size_t GetHashChainBufferSize(const Parameters* const parameters)
+{
+	const size_t key_bytes = parameters->minimum_match_length * parameters->bytes_per_value;
+	const size_t total_heads = (size_t)1 << GetHashBits(key_bytes, parameters->bytes_per_value, parameters->maximum_match_distance);
+	const size_t total_padded_values = parameters->padding + parameters->total_values;
+
+	if (parameters->total_jobs == 0)
+		return total_heads * sizeof(size_t) + parameters->maximum_match_distance * 2 * sizeof(ClownLZSS_Link);
+
+	/* Every link is kept, so that the jobs can search any part of the data, and each job has room for its matches. */
+	if (total_padded_values > (size_t)-1 / 2 / sizeof(ClownLZSS_Link) - total_heads
+	 || parameters->total_jobs > ((size_t)-1 - total_heads * sizeof(size_t) - total_padded_values * 2 * sizeof(ClownLZSS_Link)) / (CLOWNLZSS_JOB_MATCHES * sizeof(FoundMatch) + sizeof(size_t)))
+		return 0;
+
+	return total_heads * sizeof(size_t) + parameters->total_jobs * (CLOWNLZSS_JOB_MATCHES * sizeof(FoundMatch) + sizeof(size_t)) + total_padded_values * 2 * sizeof(ClownLZSS_Link);
+}
+
+static void FindMatchesHashChainInParallel(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, void* const buffer)
+{
+	const size_t maximum_match_distance = parameters->maximum_match_distance;
+	const size_t key_values = parameters->minimum_match_length;
+	const size_t key_bytes = key_values * parameters->bytes_per_value;
+	const unsigned int hash_bits = GetHashBits(key_bytes, parameters->bytes_per_value, maximum_match_distance);
+	const size_t total_heads = (size_t)1 << hash_bits;
+	const size_t total_padded_values = parameters->padding + parameters->total_values;
+	const size_t first_parsed_value = parameters->padding + parameters->history;
+	const size_t end_parsed_value = parameters->padding + parameters->parse_end;
+	const size_t total_jobs = parameters->total_jobs;
+
+	/* The same as below, except that every link is kept instead of just the window's. */
+	size_t* const heads = (size_t*)buffer;
+	FoundMatch* const found_matches = (FoundMatch*)&heads[total_heads];
+	size_t* const searched_ends = (size_t*)&found_matches[total_jobs * CLOWNLZSS_JOB_MATCHES];
+	ClownLZSS_Link* const links = (ClownLZSS_Link*)&searched_ends[total_jobs];
+	ClownLZSS_Link* const run_links = &links[total_padded_values];
+
+	const size_t DUMMY = -1;
+	size_t next_parsed_value = first_parsed_value;
+	HashChainJobs jobs;
+	HashChainSearch search;
+	size_t i, job, first_value;
+
+	for (i = 0; i < total_heads; ++i)
+		heads[i] = DUMMY;
+
+	/* Linking the strings is quick, and each link depends on the last, so do all of it up-front. */
+	for (i = 0; i < end_parsed_value; ++i)
+	{
+		if (i + key_values <= total_padded_values)
+		{
+			LinkHashChain(heads, links, run_links, (size_t)-1, maximum_match_distance, i, GetHash(parameters, i, key_bytes, hash_bits));
+		}
+		else
+		{
+			links[i] = 0;
+			run_links[i] = 0;
+		}
+	}
+
+	jobs.parameters = parameters;
+	jobs.links = links;
+	jobs.run_links = run_links;
+	jobs.found_matches = found_matches;
+	jobs.searched_ends = searched_ends;
+	jobs.end_value = end_parsed_value;
+
+	/* This only searches what the jobs ran out of room for. */
+	InitialiseHashChainSearch(&search, links, run_links, (size_t)-1, NULL, 0);
+
+	/* Searching the chains only depends on the data, so the jobs do that for a stretch of it at once,
+	   and then the matches that they found are relaxed in order, the same as if they were found here. */
+	for (first_value = first_parsed_value; first_value < end_parsed_value; first_value += total_jobs * CLOWNLZSS_JOB_VALUES)
+	{
+		jobs.first_value = first_value;
+		parameters->run_jobs(SearchHashChainJob, &jobs, total_jobs, parameters->run_jobs_user);
+
+		for (job = 0; job < total_jobs; ++job)
+		{
+			const FoundMatch *match = &found_matches[job * CLOWNLZSS_JOB_MATCHES];
+			const size_t job_first_value = first_value + job * CLOWNLZSS_JOB_VALUES;
+			const size_t job_end_value = CLOWNLZSS_MIN(job_first_value + CLOWNLZSS_JOB_VALUES, end_parsed_value);
+
+			for (i = job_first_value; i < job_end_value; ++i)
+			{
+				const size_t position = i - parameters->padding;
+				const int searched = i < searched_ends[job];
+				const size_t total_matches = searched ? match->minimum_length : 0;
+				size_t longest_match_length = searched ? match->maximum_length : 0;
+
+				if (searched)
+					++match;
+
+				if (i >= next_parsed_value)
+				{
+					VisitPosition(parameters, node_meta_array, position);
+
+					if (searched)
+					{
+						size_t j;
+
+						for (j = 0; j < total_matches; ++j)
+							RelaxMatch(parameters, node_meta_array, position, match[j].distance, match[j].minimum_length, match[j].maximum_length);
+					}
+					else
+					{
+						search.run_length = GetPaddedRunLength(parameters, i);
+						longest_match_length = SearchHashChain(parameters, node_meta_array, &search, i, GetFirstLinkedString(&search, i));
+					}
+
+					RelaxLiteral(parameters, node_meta_array, position);
+
+					next_parsed_value = parameters->padding + GetNextParsedPosition(parameters, node_meta_array, position, longest_match_length);
+				}
+
+				match += total_matches;
+			}
+		}
+	}
+}
+
+static void FindMatchesHashChain(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, void* const buffer)
+{
+	const size_t maximum_match_distance = parameters->maximum_match_distance;
+	const size_t key_values = parameters->minimum_match_length;
+	const size_t key_bytes = key_values * parameters->bytes_per_value;
+	const unsigned int hash_bits = GetHashBits(key_bytes, parameters->bytes_per_value, maximum_match_distance);
+	const size_t total_heads = (size_t)1 << hash_bits;
+	const size_t total_padded_values = parameters->padding + parameters->total_values;
+	const size_t first_parsed_value = parameters->padding + parameters->history;
+	const size_t end_parsed_value = parameters->padding + parameters->parse_end;
+
+	/* The hash-chains: `heads` holds the most recent padded position for each hash, while
+	   `links` holds the distance from each position in the window to the previous position
+	   with the same hash, or 0 if there is not one within the window. In a run, every position
+	   is linked to the one right before it, so `run_links` holds the distance to the first
+	   position in the chain that is not part of that unbroken sequence, skipping the rest of it. */
+	size_t* const heads = (size_t*)buffer;
+	ClownLZSS_Link* const links = (ClownLZSS_Link*)&heads[total_heads];
+	ClownLZSS_Link* const run_links = &links[maximum_match_distance];
+
+	const size_t DUMMY = -1;
+	const size_t first_linked_value = GetFirstLinkedValue(parameters);
+	size_t next_parsed_value = first_parsed_value;
+	HashChainSearch search;
+	size_t i;
+
+	if (parameters->total_jobs != 0)
+	{
+		FindMatchesHashChainInParallel(parameters, node_meta_array, buffer);
+		return;
+	}
+
+	/* Initialise the hash-chain heads */
+	for (i = 0; i < total_heads; ++i)
+		heads[i] = DUMMY;
+
+	InitialiseHashChainSearch(&search, links, run_links, maximum_match_distance, NULL, 0);
+
+	/* Advance through the filler values, the history, and then the data one step at a time.
+	   The filler values and history are only added to the hash-chains, as there is nothing to compress there. */
+	for (i = first_linked_value; i < end_parsed_value; ++i)
+	{
+		const size_t position = i - parameters->padding;
+		const int key_available = i + key_values <= total_padded_values;
+		const size_t hash = key_available ? GetHash(parameters, i, key_bytes, hash_bits) : 0;
+
+		/* Count how many values before this one are the same as it. */
+		if (i == first_linked_value)
+			search.run_length = GetPaddedRunLength(parameters, i);
+		else if (PaddedValuesEqual(parameters, i - 1, i))
+			++search.run_length;
+		else
+			search.run_length = 0;
+
+		if (i >= next_parsed_value)
+		{
+			size_t longest_match_length;
+
+			VisitPosition(parameters, node_meta_array, position);
+
+			/* `heads[hash]` is the most recent string with the same hash. */
+			longest_match_length = SearchHashChain(parameters, node_meta_array, &search, i, key_available ? heads[hash] : DUMMY);
+
+			RelaxLiteral(parameters, node_meta_array, position);
+
+			next_parsed_value = parameters->padding + GetNextParsedPosition(parameters, node_meta_array, position, longest_match_length);
+		}
+
+		if (key_available)
+			LinkHashChain(heads, links, run_links, maximum_match_distance, maximum_match_distance, i, hash);
+	}
+}
+
+/*********************\
+* Binary tree finder *
+\*********************/
+
+/* Like the hash-chains, except that the strings which share a hash are kept in a binary tree that is sorted by
+   the strings themselves, with the most recent string at the root. Searching the tree visits only the strings that
+   are closer to the current string than any more-recent string, which means that every match that it finds is
+   longer than the last, and that the nearest match for every length is among them. The current string is
+   inserted as the tree's new root during the search. */
+
+static size_t GetCommonBytes(const Parameters* const parameters, const size_t older_byte_index, const size_t newer_byte_index, const size_t length, const size_t maximum_length)
+{
+	return length + parameters->compare_bytes(GetPaddedBytes(parameters, older_byte_index + length), GetPaddedBytes(parameters, newer_byte_index + length), maximum_length - length);
+}
+
+static size_t GetBinaryTreeBufferSize(const Parameters* const parameters)
+{
+	const size_t key_bytes = parameters->minimum_match_length * parameters->bytes_per_value;
+	const size_t total_heads = (size_t)1 << GetHashBits(key_bytes, parameters->bytes_per_value, parameters->maximum_match_distance);
+
+	/* The positions are stored in 32-bit links. */
+	if (parameters->padding + parameters->total_values >= 0xFFFFFFFF)
+		return 0;
+
+	return (total_heads + (parameters->maximum_match_distance + 1) * 2) * sizeof(ClownLZSS_Link);
+}
+
+static void SearchBinaryTrees(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, void* const buffer, FieldWriter* const candidates)
+{
+	/* If `candidates` is not NULL, then the matches are written there instead of being relaxed (see `FindMatchesCandidates`). */
+	const size_t maximum_match_distance = parameters->maximum_match_distance;
+	const size_t bytes_per_value = parameters->bytes_per_value;
+	const size_t key_values = parameters->minimum_match_length;
+	const size_t key_bytes = key_values * bytes_per_value;
+	const unsigned int hash_bits = GetHashBits(key_bytes, bytes_per_value, maximum_match_distance);
+	const size_t total_heads = (size_t)1 << hash_bits;
+	const size_t total_padded_values = parameters->padding + parameters->total_values;
+	const size_t first_parsed_value = parameters->padding + parameters->history;
+	const size_t end_parsed_value = parameters->padding + parameters->parse_end;
+	/* One more than the window, so that the current string never shares a slot with a string in the window. */
+	const size_t cyclic_buffer_size = maximum_match_distance + 1;
+
+	/* `heads` holds the root of each tree, and `children` holds the left and right child of each string in the window. */
+	ClownLZSS_Link* const heads = (ClownLZSS_Link*)buffer;
+	ClownLZSS_Link* const children = &heads[total_heads];
+
+	size_t next_parsed_value = first_parsed_value;
+	size_t previous_distance = 0, previous_length = 0;
+	size_t i;
+
+	/* Initialise the tree roots */
+	for (i = 0; i < total_heads; ++i)
+		heads[i] = CLOWNLZSS_LINK_NONE;
+
+	/* Advance through the filler values, the history, and then the data one step at a time.
+	   The filler values and history are only added to the trees, as there is nothing to compress there. */
+	for (i = GetFirstLinkedValue(parameters); i < end_parsed_value; ++i)
+	{
+		const size_t position = i - parameters->padding;
+		const int search = i >= next_parsed_value;
+		size_t best_length = 0, best_distance = 0;
+
+		if (search && candidates == NULL)
+			VisitPosition(parameters, node_meta_array, position);
+
+		/* Strings that are too close to the end for a useful match are not needed by any later string either. */
+		if (i + key_values <= total_padded_values)
+		{
+			const size_t hash = GetHash(parameters, i, key_bytes, hash_bits);
+			const size_t maximum_length = CLOWNLZSS_MIN(parameters->maximum_match_length, total_padded_values - i);
+			const size_t maximum_length_bytes = maximum_length * bytes_per_value;
+			const size_t nice_length_bytes = CLOWNLZSS_MIN(maximum_length, parameters->nice_match_length) * bytes_per_value;
+
+			ClownLZSS_Link *left_pointer = &children[(i % cyclic_buffer_size) * 2 + 0];
+			ClownLZSS_Link *right_pointer = &children[(i % cyclic_buffer_size) * 2 + 1];
+			size_t left_length = 0, right_length = 0;
+			size_t chain_length = 0;
+			size_t match_string = heads[hash];
+
+			heads[hash] = (ClownLZSS_Link)i;
+
+			for (;;)
+			{
+				ClownLZSS_Link *match_children;
+				size_t length;
+
+				/* Everything else in the tree has left the LZSS sliding window, or enough of the tree has been searched.
+				   In the latter case, the rest of the tree is lost, so later strings will find fewer matches. */
+				if (match_string == CLOWNLZSS_LINK_NONE || i - match_string > maximum_match_distance || chain_length++ == parameters->maximum_chain_length)
+				{
+					*left_pointer = *right_pointer = CLOWNLZSS_LINK_NONE;
+					break;
+				}
+
+				match_children = &children[(match_string % cyclic_buffer_size) * 2];
+
+				/* Everything between the bounds of the search so far shares at least this many bytes with the current string.
+				   The best match of the previous string still covers all but one value of it at the same distance, too. */
+				length = CLOWNLZSS_MIN(left_length, right_length);
+
+				if (i - match_string == previous_distance && previous_length > 1)
+					length = CLOWNLZSS_MAX(length, (previous_length - 1) * bytes_per_value);
+
+				length = GetCommonBytes(parameters, match_string * bytes_per_value, i * bytes_per_value, length, maximum_length_bytes);
+
+				if (length / bytes_per_value > best_length)
+				{
+					const size_t previous_best_length = best_length;
+
+					best_length = length / bytes_per_value;
+					best_distance = i - match_string;
+
+					/* This is the nearest match for every length that is longer than the previous match. */
+					if (search && best_length >= key_values)
+					{
+						if (candidates != NULL)
+						{
+							PutField(candidates, best_distance, CLOWNLZSS_CANDIDATE_FIELD_BYTES);
+							PutField(candidates, best_length, CLOWNLZSS_CANDIDATE_FIELD_BYTES);
+						}
+						else
+						{
+							RelaxMatch(parameters, node_meta_array, position, i - match_string, CLOWNLZSS_MAX(previous_best_length + 1, key_values), best_length);
+						}
+					}
+				}
+
+				if (length >= nice_length_bytes)
+				{
+					/* The old string is no better than the current string for any later string, so replace it.
+					   When stopping early at a nice length, this is only nearly true, so later strings may miss a few matches. */
+					*left_pointer = match_children[0];
+					*right_pointer = match_children[1];
+					break;
+				}
+
+				if (*GetPaddedBytes(parameters, match_string * bytes_per_value + length) < *GetPaddedBytes(parameters, i * bytes_per_value + length))
+				{
+					*left_pointer = (ClownLZSS_Link)match_string;
+					left_pointer = &match_children[1];
+					match_string = *left_pointer;
+					left_length = length;
+				}
+				else
+				{
+					*right_pointer = (ClownLZSS_Link)match_string;
+					right_pointer = &match_children[0];
+					match_string = *right_pointer;
+					right_length = length;
+				}
+			}
+		}
+
+		previous_distance = best_distance;
+		previous_length = best_length;
+
+		/* Each position's candidates end with a distance of 0. */
+		if (search && candidates != NULL)
+		{
+			PutField(candidates, 0, CLOWNLZSS_CANDIDATE_FIELD_BYTES);
+		}
+		else if (search)
+		{
+			RelaxLiteral(parameters, node_meta_array, position);
+
+			next_parsed_value = parameters->padding + GetNextParsedPosition(parameters, node_meta_array, position, best_length);
+		}
+	}
+}
+
+static void FindMatchesBinaryTree(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, void* const buffer)
+{
+	SearchBinaryTrees(parameters, node_meta_array, buffer, NULL);
+}
+
+/********************\
+* Suffix array finder *
+\********************/
+
+/* This finder builds a suffix array of the whole (padded) input, and then uses its LCP array to build the
+   'LCP interval tree', which is a suffix tree without the edge labels. Every node of the tree remembers the
+   most recent position below it, so walking from a position's leaf to the root yields the nearest match
+   for every match length, without comparing a single byte. Nodes that are deeper than the maximum match
+   length are merged into their ancestors, which bounds the length of every walk. */
+
+static void BuildSuffixArray(const unsigned char* const values, const size_t bytes_per_value, const size_t total_values, ClownLZSS_Link* const suffix_array, ClownLZSS_Link* const ranks, ClownLZSS_Link* const scratch, ClownLZSS_Link* const counts)
+{
+	const size_t total_counts = CLOWNLZSS_MAX(total_values, 0x100) + 1;
+	size_t i, byte, h;
+
+	/* Sort the suffixes by their first value, using a least-significant-byte-first radix sort. */
+	for (i = 0; i < total_values; ++i)
+		suffix_array[i] = (ClownLZSS_Link)i;
+
+	for (byte = bytes_per_value; byte-- != 0; )
+	{
+		for (i = 0; i < 0x100; ++i)
+			counts[i] = 0;
+
+		for (i = 0; i < total_values; ++i)
+			++counts[values[i * bytes_per_value + byte]];
+
+		for (i = 1; i < 0x100; ++i)
+			counts[i] += counts[i - 1];
+
+		for (i = total_values; i-- != 0; )
+			scratch[--counts[values[suffix_array[i] * bytes_per_value + byte]]] = suffix_array[i];
+
+		for (i = 0; i < total_values; ++i)
+			suffix_array[i] = scratch[i];
+	}
+
+	ranks[suffix_array[0]] = 0;
+
+	for (i = 1; i < total_values; ++i)
+		ranks[suffix_array[i]] = ranks[suffix_array[i - 1]] + !ValuesEqual(&values[suffix_array[i] * bytes_per_value], &values[suffix_array[i - 1] * bytes_per_value], bytes_per_value);
+
+	/* Prefix-doubling: sort by the first `h * 2` values, using the ranks of the first `h` values as keys. */
+	for (h = 1; ranks[suffix_array[total_values - 1]] != total_values - 1; h *= 2)
+	{
+		size_t total_scratch;
+
+		/* Sort by the second key. Suffixes that are too short to have one come first. */
+		total_scratch = 0;
+
+		for (i = total_values - CLOWNLZSS_MIN(h, total_values); i < total_values; ++i)
+			scratch[total_scratch++] = (ClownLZSS_Link)i;
+
+		for (i = 0; i < total_values; ++i)
+			if (suffix_array[i] >= h)
+				scratch[total_scratch++] = (ClownLZSS_Link)(suffix_array[i] - h);
+
+		/* Stable-sort by the first key. */
+		for (i = 0; i < total_counts; ++i)
+			counts[i] = 0;
+
+		for (i = 0; i < total_values; ++i)
+			++counts[ranks[i]];
+
+		for (i = 1; i < total_counts; ++i)
+			counts[i] += counts[i - 1];
+
+		for (i = total_values; i-- != 0; )
+			suffix_array[--counts[ranks[scratch[i]]]] = scratch[i];
+
+		/* Re-rank the suffixes. */
+		scratch[suffix_array[0]] = 0;
+
+		for (i = 1; i < total_values; ++i)
+		{
+			const size_t current = suffix_array[i];
+			const size_t previous = suffix_array[i - 1];
+			const int same = ranks[current] == ranks[previous]
+				&& (current + h < total_values ? (previous + h < total_values && ranks[current + h] == ranks[previous + h]) : previous + h >= total_values);
+
+			scratch[current] = scratch[previous] + !same;
+		}
+
+		for (i = 0; i < total_values; ++i)
+			ranks[i] = scratch[i];
+	}
+}
+
+static void BuildLCPArray(const Parameters* const parameters, const unsigned char* const values, const size_t total_values, const ClownLZSS_Link* const suffix_array, const ClownLZSS_Link* const ranks, const size_t maximum_length, ClownLZSS_Link* const lcp)
+{
+	size_t i, h;
+
+	/* Kasai's algorithm. `lcp[rank]` is the length of the prefix that the suffix shares with the one sorted before it. */
+	h = 0;
+	lcp[0] = 0;
+
+	for (i = 0; i < total_values; ++i)
+	{
+		if (ranks[i] == 0)
+		{
+			h = 0;
+		}
+		else
+		{
+			const size_t other = suffix_array[ranks[i] - 1];
+			const size_t bytes_per_value = parameters->bytes_per_value;
+
+			h += CompareValues(parameters, &values[(i + h) * bytes_per_value], &values[(other + h) * bytes_per_value], total_values - CLOWNLZSS_MAX(i, other) - h);
+
+			lcp[ranks[i]] = (ClownLZSS_Link)CLOWNLZSS_MIN(h, maximum_length);
+
+			if (h != 0)
+				--h;
+		}
+	}
+}
+
+static size_t BuildLCPIntervalTree(const ClownLZSS_Link* const lcp, const size_t total_values, ClownLZSS_Link* const leaf_parents, ClownLZSS_Link* const node_depths, ClownLZSS_Link* const node_parents, ClownLZSS_Link* const stack)
+{
+	size_t total_nodes, stack_top, r;
+	ClownLZSS_Link previous_node;
+
+	/* Node 0 is the root. */
+	node_depths[0] = 0;
+	node_parents[0] = CLOWNLZSS_LINK_NONE;
+	total_nodes = 1;
+
+	stack[0] = 0;
+	stack_top = 0;
+	previous_node = 0;
+
+	for (r = 1; r < total_values; ++r)
+	{
+		const ClownLZSS_Link h = lcp[r];
+
+		/* Close every interval that is deeper than the boundary between these two suffixes. */
+		while (node_depths[stack[stack_top]] > h)
+		{
+			const ClownLZSS_Link closed = stack[stack_top--];
+
+			if (node_depths[stack[stack_top]] < h)
+			{
+				/* The closed interval's parent is an interval that begins to the left of it. */
+				node_depths[total_nodes] = h;
+				stack[++stack_top] = (ClownLZSS_Link)total_nodes++;
+			}
+
+			node_parents[closed] = stack[stack_top];
+		}
+
+		if (node_depths[stack[stack_top]] < h)
+		{
+			node_depths[total_nodes] = h;
+			stack[++stack_top] = (ClownLZSS_Link)total_nodes++;
+		}
+
+		/* The leaf before the boundary belongs to the deeper of the intervals on either side of it. */
+		leaf_parents[r - 1] = h > node_depths[previous_node] ? stack[stack_top] : previous_node;
+		previous_node = stack[stack_top];
+	}
+
+	leaf_parents[total_values - 1] = previous_node;
+
+	while (stack_top != 0)
+	{
+		const ClownLZSS_Link closed = stack[stack_top--];
+		node_parents[closed] = stack[stack_top];
+	}
+
+	return total_nodes;
+}
+
+static size_t GetSuffixArrayBufferSize(const Parameters* const parameters)
+{
+	const size_t total_padded_values = parameters->padding + parameters->total_values;
+	const size_t total_counts = CLOWNLZSS_MAX(total_padded_values, 0x100) + 1;
+
+	/* Every node's depth is a match length, so the indices cannot be allowed to overflow. */
+	if (total_padded_values >= 0xFFFFFFFF || total_padded_values > ((size_t)-1 - total_counts * sizeof(ClownLZSS_Link)) / (sizeof(ClownLZSS_Link) * 6 + parameters->bytes_per_value))
+		return 0;
+
+	return (total_padded_values * 6 + total_counts) * sizeof(ClownLZSS_Link) + total_padded_values * parameters->bytes_per_value;
+}
+
+static void FindMatchesSuffixArray(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, void* const buffer)
+{
+	const size_t bytes_per_value = parameters->bytes_per_value;
+	const size_t padding = parameters->padding;
+	const size_t total_padded_values = padding + parameters->total_values;
+	const size_t total_counts = CLOWNLZSS_MAX(total_padded_values, 0x100) + 1;
+	const size_t maximum_length = CLOWNLZSS_MIN(parameters->maximum_match_length, parameters->total_values);
+
+	ClownLZSS_Link* const suffix_array = (ClownLZSS_Link*)buffer;
+	ClownLZSS_Link* const ranks = &suffix_array[total_padded_values];
+	ClownLZSS_Link* const lcp = &ranks[total_padded_values];
+	ClownLZSS_Link* const node_depths = &lcp[total_padded_values];
+	ClownLZSS_Link* const node_parents = &node_depths[total_padded_values];
+	ClownLZSS_Link* const node_positions = &node_parents[total_padded_values];
+	ClownLZSS_Link* const counts = &node_positions[total_padded_values];
+	unsigned char* const values = (unsigned char*)&counts[total_counts];
+	/* These are only needed while building, so they share memory with arrays that are filled-in later. */
+	ClownLZSS_Link* const scratch = node_depths;
+	ClownLZSS_Link* const leaf_parents = suffix_array;
+	ClownLZSS_Link* const stack = counts;
+
+	size_t total_nodes, next_parsed_value, i;
+
+	/* Produce a copy of the data with the filler values physically in front of it. */
+	for (i = 0; i < padding * bytes_per_value; ++i)
+		values[i] = (unsigned char)parameters->filler_value;
+
+	for (i = 0; i < parameters->total_values * bytes_per_value; ++i)
+		values[padding * bytes_per_value + i] = parameters->data[i];
+
+	BuildSuffixArray(values, bytes_per_value, total_padded_values, suffix_array, ranks, scratch, counts);
+	BuildLCPArray(parameters, values, total_padded_values, suffix_array, ranks, maximum_length, lcp);
+	total_nodes = BuildLCPIntervalTree(lcp, total_padded_values, leaf_parents, node_depths, node_parents, stack);
+
+	for (i = 0; i < total_nodes; ++i)
+		node_positions[i] = CLOWNLZSS_LINK_NONE;
+
+	next_parsed_value = padding + parameters->history;
+
+	/* Advance through the filler values, the history, and then the data one step at a time.
+	   The filler values and history are only added to the tree, as there is nothing to compress there. */
+	for (i = 0; i < padding + parameters->parse_end; ++i)
+	{
+		const size_t position = i - padding;
+		const int search = i >= next_parsed_value;
+		size_t longest_match_length = 0;
+		ClownLZSS_Link node;
+
+		if (search)
+			VisitPosition(parameters, node_meta_array, position);
+
+		/* Walk from the leaf to the root: the deeper the node, the longer the match, and the further away the
+		   nearest position that produces it. Each node is the nearest match for every length down to its parent's. */
+		for (node = leaf_parents[ranks[i]]; node != CLOWNLZSS_LINK_NONE && node_depths[node] >= parameters->minimum_match_length; node = node_parents[node])
+		{
+			if (search && node_positions[node] != CLOWNLZSS_LINK_NONE && i - node_positions[node] <= parameters->maximum_match_distance)
+			{
+				const size_t parent_depth = node_parents[node] == CLOWNLZSS_LINK_NONE ? 0 : node_depths[node_parents[node]];
+
+				RelaxMatch(parameters, node_meta_array, position, i - node_positions[node], CLOWNLZSS_MAX(parent_depth + 1, parameters->minimum_match_length), node_depths[node]);
+				longest_match_length = CLOWNLZSS_MAX(longest_match_length, node_depths[node]);
+			}
+
+			node_positions[node] = (ClownLZSS_Link)i;
+		}
+
+		if (search)
+		{
+			RelaxLiteral(parameters, node_meta_array, position);
+
+			next_parsed_value = padding + GetNextParsedPosition(parameters, node_meta_array, position, longest_match_length);
+		}
+	}
+}
+
+/**************\
+* Hints finder *
+\**************/
+
+/* Nothing is searched for at all: the only matches are the hints, which are relaxed by `VisitPosition` like those of every
+   other match finder. */
+
+static void FindMatchesHints(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array)
+{
+	size_t position;
+
+	for (position = parameters->history; position < parameters->parse_end; ++position)
+	{
+		VisitPosition(parameters, node_meta_array, position);
+		RelaxLiteral(parameters, node_meta_array, position);
+	}
+}
+
+/*******************\
+* Candidates finder *
+\*******************/
+
+/* Candidates are a magic number, the header fields, and then the nearest match of every length at each position, as found
+   by `ClownLZSS_FindCandidates` with the binary trees: a distance and a length for each one, in order of increasing
+   distance, followed by a distance of 0. As only the nearest matches are kept, the ones that are within a smaller window
+   come first, and each match only has to relax the lengths that the ones before it did not reach, the same as when the
+   binary trees are searched directly. */
+
+#define CLOWNLZSS_CANDIDATES_MAGIC "CLZSSCA1"
+#define CLOWNLZSS_CANDIDATES_HEADER_FIELDS 6
+#define CLOWNLZSS_CANDIDATES_HEADER_BYTES (CLOWNLZSS_MAGIC_BYTES + CLOWNLZSS_CANDIDATES_HEADER_FIELDS * CLOWNLZSS_CANDIDATE_FIELD_BYTES)
+
+static void GetCandidatesHeader(const Parameters* const parameters, size_t* const fields)
+{
+	fields[0] = parameters->bytes_per_value;
+	fields[1] = (size_t)(parameters->filler_value + 1);
+	fields[2] = parameters->minimum_match_length;
+	fields[3] = CLOWNLZSS_MIN(parameters->maximum_match_length, parameters->total_values);
+	fields[4] = parameters->maximum_match_distance;
+	fields[5] = parameters->total_values;
+}
+
+static void FindMatchesCandidates(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array)
+{
+	const unsigned char *candidate = parameters->candidates;
+	const unsigned char* const candidates_end = parameters->candidates + parameters->candidates_size;
+	size_t next_parsed_position = parameters->history;
+	size_t position;
+
+	/* The candidates of the history still have to be read past. */
+	for (position = 0; position < parameters->parse_end; ++position)
+	{
+		const int search = position >= next_parsed_position;
+		const size_t maximum_length = CLOWNLZSS_MIN(parameters->maximum_match_length, parameters->total_values - position);
+		size_t longest_match_length = 0;
+
+		if (search)
+			VisitPosition(parameters, node_meta_array, position);
+
+		for (;;)
+		{
+			size_t distance, length;
+
+			if ((size_t)(candidates_end - candidate) < CLOWNLZSS_CANDIDATE_FIELD_BYTES * 2 || !GetField(candidate, CLOWNLZSS_CANDIDATE_FIELD_BYTES, &distance))
+			{
+				candidate = candidates_end;
+				break;
+			}
+
+			candidate += CLOWNLZSS_CANDIDATE_FIELD_BYTES;
+
+			if (distance == 0)
+				break;
+
+			if (!GetField(candidate, CLOWNLZSS_CANDIDATE_FIELD_BYTES, &length))
+				length = 0;
+
+			candidate += CLOWNLZSS_CANDIDATE_FIELD_BYTES;
+
+			/* The candidates were found for the largest window and the longest match of several formats, so only use the
+			   parts that suit this one. */
+			if (search && distance <= parameters->maximum_match_distance && distance <= parameters->padding + position && length > longest_match_length)
+			{
+				const size_t minimum_length = CLOWNLZSS_MAX(longest_match_length + 1, parameters->minimum_match_length);
+				const size_t usable_length = CLOWNLZSS_MIN(length, maximum_length);
+
+				if (minimum_length <= usable_length)
+					RelaxMatch(parameters, node_meta_array, position, distance, minimum_length, usable_length);
+
+				longest_match_length = CLOWNLZSS_MAX(longest_match_length, usable_length);
+			}
+		}
+
+		if (search)
+		{
+			RelaxLiteral(parameters, node_meta_array, position);
+
+			next_parsed_position = GetNextParsedPosition(parameters, node_meta_array, position, longest_match_length);
+		}
+	}
+}
+
+static void InitialiseCandidates(Parameters* const parameters, const ClownLZSS_Settings* const settings)
+{
+	size_t header[CLOWNLZSS_CANDIDATES_HEADER_FIELDS];
+	size_t i;
+
+	if (settings->candidates == NULL || settings->candidates_size < CLOWNLZSS_CANDIDATES_HEADER_BYTES
+	 || parameters->compare_bytes(settings->candidates, (const unsigned char*)CLOWNLZSS_CANDIDATES_MAGIC, CLOWNLZSS_MAGIC_BYTES) != CLOWNLZSS_MAGIC_BYTES)
+		return;
+
+	GetCandidatesHeader(parameters, header);
+
+	/* The values must be the same, but the candidates can have a shorter minimum match length, and a longer maximum match
+	   length and window, than this format needs. */
+	for (i = 0; i < CLOWNLZSS_CANDIDATES_HEADER_FIELDS; ++i)
+	{
+		size_t field;
+
+		if (!GetField(&settings->candidates[CLOWNLZSS_MAGIC_BYTES + i * CLOWNLZSS_CANDIDATE_FIELD_BYTES], CLOWNLZSS_CANDIDATE_FIELD_BYTES, &field))
+			return;
+
+		if (i == 2 ? field > header[i] : i == 3 || i == 4 ? field < header[i] : field != header[i])
+			return;
+	}
+
+	parameters->candidates = &settings->candidates[CLOWNLZSS_CANDIDATES_HEADER_BYTES];
+	parameters->candidates_size = settings->candidates_size - CLOWNLZSS_CANDIDATES_HEADER_BYTES;
+}
+
+/*************\
+* Lazy parser *
+\*************/
+
+/* Instead of finding every match, this finds only the one that saves the most at each position, and takes it unless
+   the next position has a better one, like zlib does. The values between the matches are still parsed with literals
+   and the extra matches callback, so formats with other ways of encoding them can still use them. The costs stay
+   totals from the start of the parse, so the graph is just a shortest path with most of its edges left out.
+   Without any of those other edges, that path is the only one, so the matches are written out as they are taken instead. */
+
+typedef struct LazyMatch
+{
+	size_t distance;
+	size_t length;
+	/* How much cheaper the match is than the literals that it replaces, or 0 if there is no match. */
+	size_t savings;
+} LazyMatch;
+
+typedef struct LazyOutput
+{
+	/* If NULL, then the matches are relaxed into the graph instead. */
+	ClownLZSS_Match *matches;
+	size_t total_matches;
+	/* The values from here to the next match that is taken are literals. */
+	size_t first_literal;
+} LazyOutput;
+
+static void FindLazyMatch(const Parameters* const parameters, const size_t* const heads, const ClownLZSS_Link* const links, const size_t hash, const size_t padded_position, LazyMatch* const match)
+{
+	const size_t position = padded_position - parameters->padding;
+	const size_t maximum_length = CLOWNLZSS_MIN(parameters->maximum_match_length, parameters->parse_end - position);
+	/* Walking the whole chain is what makes the optimal parser slow, so it is never unlimited here. */
+	const size_t maximum_chain_length = CLOWNLZSS_MIN(parameters->maximum_chain_length, CLOWNLZSS_LAZY_MAXIMUM_CHAIN_LENGTH);
+
+	const size_t DUMMY = -1;
+	size_t match_string;
+	size_t chain_length = 0;
+
+	match->distance = 0;
+	match->length = 0;
+	match->savings = 0;
+
+	for (match_string = heads[hash]; match_string != DUMMY && padded_position - match_string <= parameters->maximum_match_distance; )
+	{
+		const size_t distance = padded_position - match_string;
+		const unsigned char* const end_bytes = &parameters->data[(position + match->length) * parameters->bytes_per_value];
+		ClownLZSS_Link link;
+		size_t length;
+
+		/* A match can only be longer than the best so far if the value after the best one matches too, so check that first, like zlib does. */
+		if (match->length != 0 && distance <= position && !ValuesEqual(end_bytes, end_bytes - distance * parameters->bytes_per_value, parameters->bytes_per_value))
+			length = 0;
+		else
+			length = GetMatchLength(parameters, position, distance, 0, maximum_length);
+
+		/* Assuming that matches never get cheaper as they get further away, only a longer match can save more.
+		   If the match cannot be encoded at its full length, then shorten it until it can. */
+		if (length > match->length)
+		{
+			for (; length >= parameters->minimum_match_length; --length)
+			{
+				const size_t cost = GetMatchCost(parameters, distance, length);
+
+				if (IsMatchUseful(cost, length, parameters->literal_cost))
+				{
+					const size_t savings = length * parameters->literal_cost - cost;
+
+					/* Nearer matches win ties. */
+					if (savings > match->savings)
+					{
+						match->distance = distance;
+						match->length = length;
+						match->savings = savings;
+					}
+
+					break;
+				}
+			}
+		}
+
+		link = links[match_string % parameters->maximum_match_distance];
+
+		if (link == 0 || match->length == maximum_length || match->length >= parameters->nice_match_length || ++chain_length == maximum_chain_length)
+			break;
+
+		match_string -= link;
+	}
+}
+
+static int CanEmitLazyMatches(const Parameters* const parameters)
+{
+	/* Every other kind of edge would give the graph a choice to make. */
+	return parameters->parser == CLOWNLZSS_PARSER_LAZY && !HasExtraMatches(parameters) && parameters->literal_runs == NULL
+		&& parameters->repeats == NULL && parameters->descriptor_graph == NULL && parameters->cut_points == NULL && parameters->kept_nodes == 0;
+}
+
+static void TakeLazyMatch(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, LazyOutput* const output, const size_t position, const size_t distance, const size_t length)
+{
+	ClownLZSS_Match* const matches = output->matches;
+	size_t i;
+
+	if (matches == NULL)
+	{
+		RelaxMatch(parameters, node_meta_array, position, distance, length, length);
+		return;
+	}
+
+	for (i = output->first_literal; i < position; ++i)
+	{
+		matches[output->total_matches].source = i + 1;
+		matches[output->total_matches].destination = i;
+		matches[output->total_matches].length = 1;
+		++output->total_matches;
+	}
+
+	/* A length of 0 only writes the literals. */
+	if (length != 0)
+	{
+		matches[output->total_matches].source = position - distance;
+		matches[output->total_matches].destination = position;
+		matches[output->total_matches].length = length;
+		++output->total_matches;
+	}
+
+	output->first_literal = position + length;
+}
+
+static size_t ParseLazy(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, ClownLZSS_Match* const matches, void* const buffer)
+{
+	const size_t maximum_match_distance = parameters->maximum_match_distance;
+	const size_t key_values = parameters->minimum_match_length;
+	const size_t key_bytes = key_values * parameters->bytes_per_value;
+	const unsigned int hash_bits = GetHashBits(key_bytes, parameters->bytes_per_value, maximum_match_distance);
+	const size_t total_heads = (size_t)1 << hash_bits;
+	const size_t total_padded_values = parameters->padding + parameters->total_values;
+	const size_t first_parsed_value = parameters->padding + parameters->history;
+	const size_t end_parsed_value = parameters->padding + parameters->parse_end;
+
+	/* The same hash-chains as the hash-chain finder. */
+	size_t* const heads = (size_t*)buffer;
+	ClownLZSS_Link* const links = (ClownLZSS_Link*)&heads[total_heads];
+
+	const size_t DUMMY = -1;
+	size_t next_parsed_value = first_parsed_value;
+	LazyMatch match, pending;
+	LazyOutput output;
+	size_t i;
+
+	for (i = 0; i < total_heads; ++i)
+		heads[i] = DUMMY;
+
+	output.matches = matches;
+	output.total_matches = 0;
+	output.first_literal = parameters->history;
+
+	/* The match at the previous position, which is held back in case this position has a better one. */
+	pending.length = 0;
+
+	for (i = 0; i < end_parsed_value; ++i)
+	{
+		const size_t position = i - parameters->padding;
+		const int key_available = i + key_values <= total_padded_values;
+		const size_t hash = key_available ? GetHash(parameters, i, key_bytes, hash_bits) : 0;
+
+		if (i >= next_parsed_value)
+		{
+			if (key_available && parameters->maximum_match_length >= key_values)
+			{
+				FindLazyMatch(parameters, heads, links, hash, i, &match);
+			}
+			else
+			{
+				match.distance = 0;
+				match.length = 0;
+				match.savings = 0;
+			}
+
+			/* If the previous position's match is at least as good as this one, then take it. */
+			if (pending.length != 0 && match.savings <= pending.savings)
+			{
+				TakeLazyMatch(parameters, node_meta_array, &output, position - 1, pending.distance, pending.length);
+				next_parsed_value = i - 1 + pending.length;
+				pending.length = 0;
+			}
+
+			/* Otherwise, the previous position stays as it is, and this one is parsed. */
+			if (i >= next_parsed_value)
+			{
+				/* When the matches are written out, the literals are written along with the next match instead. */
+				if (matches == NULL)
+				{
+					VisitPosition(parameters, node_meta_array, position);
+					RelaxLiteral(parameters, node_meta_array, position);
+				}
+
+				/* A good enough match is taken without checking the next position. */
+				if (match.length >= parameters->good_match_length)
+				{
+					TakeLazyMatch(parameters, node_meta_array, &output, position, match.distance, match.length);
+					next_parsed_value = i + match.length;
+					pending.length = 0;
+				}
+				else
+				{
+					pending = match;
+					next_parsed_value = i + 1;
+				}
+			}
+		}
+
+		if (key_available)
+		{
+			links[i % maximum_match_distance] = heads[hash] != DUMMY && i - heads[hash] <= maximum_match_distance ? (ClownLZSS_Link)(i - heads[hash]) : 0;
+			heads[hash] = i;
+		}
+	}
+
+	/* There is nothing after the last position to be better than its match. */
+	if (pending.length != 0)
+		TakeLazyMatch(parameters, node_meta_array, &output, parameters->parse_end - 1, pending.distance, pending.length);
+
+	/* Write the literals after the last match. */
+	if (matches != NULL)
+		TakeLazyMatch(parameters, node_meta_array, &output, parameters->parse_end, 0, 0);
+
+	return output.total_matches;
+}
+
+/***********\
+* Workspace *
+\***********/
+
+#ifndef CLOWNLZSS_FREESTANDING
+static void* DefaultAllocate(const size_t size, void* const user)
+{
+	(void)user;
+
+	return malloc(size);
+}
+
+static void DefaultDeallocate(void* const memory, void* const user)
+{
+	(void)user;
+
+	free(memory);
+}
+#endif
+
+void ClownLZSS_InitialiseWorkspace(ClownLZSS_Workspace* const workspace, const ClownLZSS_Allocator* const allocator)
+{
+	if (allocator != NULL)
+	{
+		workspace->allocator = *allocator;
+	}
+	else
+	{
+#ifdef CLOWNLZSS_FREESTANDING
+		workspace->allocator.allocate = NULL;
+		workspace->allocator.deallocate = NULL;
+#else
+		workspace->allocator.allocate = DefaultAllocate;
+		workspace->allocator.deallocate = DefaultDeallocate;
+#endif
+		workspace->allocator.user = NULL;
+	}
+
+	workspace->buffer = NULL;
+	workspace->size = 0;
+}
+
+void ClownLZSS_InitialiseWorkspaceWithBuffer(ClownLZSS_Workspace* const workspace, void* const buffer, const size_t size)
+{
+	/* Without an allocator, the workspace can never grow or be freed. */
+	workspace->allocator.allocate = NULL;
+	workspace->allocator.deallocate = NULL;
+	workspace->allocator.user = NULL;
+	workspace->buffer = buffer;
+	workspace->size = size;
+}
+
+void ClownLZSS_DeinitialiseWorkspace(ClownLZSS_Workspace* const workspace)
+{
+	if (workspace->buffer != NULL && workspace->allocator.deallocate != NULL)
+		workspace->allocator.deallocate(workspace->buffer, workspace->allocator.user);
+
+	workspace->buffer = NULL;
+	workspace->size = 0;
+}
+
+void* ClownLZSS_ReserveWorkspace(ClownLZSS_Workspace* const workspace, const size_t size)
+{
+	if (size > workspace->size)
+	{
+		if (workspace->allocator.allocate == NULL)
+			return NULL;
+
+		/* The old contents are never needed again, so there is no point in copying them. */
+		ClownLZSS_DeinitialiseWorkspace(workspace);
+
+		workspace->buffer = workspace->allocator.allocate(size, workspace->allocator.user);
+		workspace->size = workspace->buffer == NULL ? 0 : size;
+	}
+
+	return workspace->buffer;
+}
+
+/**************\
+* Checkpoints *
+\**************/
+
+/* A checkpoint is a magic number, the header fields, the data, and then the cost, previous node index, and match offset
+   of every node in the graph, with every number being eight bytes long. */
+
+#define CLOWNLZSS_CHECKPOINT_MAGIC "CLZSSCP1"
+#define CLOWNLZSS_CHECKPOINT_FIELD_BYTES 8
+#define CLOWNLZSS_CHECKPOINT_HEADER_FIELDS 11
+#define CLOWNLZSS_CHECKPOINT_HEADER_BYTES (CLOWNLZSS_MAGIC_BYTES + CLOWNLZSS_CHECKPOINT_HEADER_FIELDS * CLOWNLZSS_CHECKPOINT_FIELD_BYTES)
+#define CLOWNLZSS_CHECKPOINT_NODE_BYTES (3 * CLOWNLZSS_CHECKPOINT_FIELD_BYTES)
+
+static int CanCheckpoint(const Parameters* const parameters, const ClownLZSS_Settings* const settings)
+{
+	/* Only the plain graph can be kept, as the literal runs, the repeat distances, and the descriptor graph are not in it.
+	   The hints are not in the checkpoint either, so the kept nodes could disagree with them.
+	   Without knowing how far the extra matches reach, it is not known how far before a change the parse must begin. */
+	return parameters->parser == CLOWNLZSS_PARSER_OPTIMAL && settings->total_literal_run_length_tiers == 0 && settings->maximum_repeat_match_length == 0
+		&& parameters->descriptor_field_bits == 0 && parameters->hints == NULL && (!HasExtraMatches(parameters) || settings->maximum_extra_match_length != 0);
+}
+
+static size_t GetCostFingerprint(const Parameters* const parameters)
+{
+	/* Different formats can share every other header field, so sample the match costs to tell them apart. */
+	const size_t longest_length = CLOWNLZSS_MIN(parameters->maximum_match_length, 0x40);
+	size_t fingerprint, distance, length;
+
+	fingerprint = 0;
+
+	for (distance = 1; ; distance = CLOWNLZSS_MIN(distance * 2, parameters->maximum_match_distance))
+	{
+		for (length = parameters->minimum_match_length; length <= longest_length; ++length)
+			fingerprint = fingerprint * 31 + GetMatchCost(parameters, distance, length);
+
+		if (distance == parameters->maximum_match_distance)
+			break;
+	}
+
+	return fingerprint;
+}
+
+static void GetCheckpointHeader(const Parameters* const parameters, const ClownLZSS_Settings* const settings, const size_t total_values, size_t* const fields)
+{
+	fields[0] = parameters->bytes_per_value;
+	fields[1] = parameters->maximum_match_length;
+	fields[2] = parameters->maximum_match_distance;
+	fields[3] = parameters->literal_cost;
+	fields[4] = (size_t)(parameters->filler_value + 1);
+	fields[5] = settings->maximum_extra_match_length;
+	fields[6] = parameters->maximum_chain_length;
+	fields[7] = parameters->nice_match_length;
+	fields[8] = parameters->good_match_length;
+	fields[9] = GetCostFingerprint(parameters);
+	fields[10] = total_values;
+}
+
+/* A value that is not a link in the compact graph is stored as `(size_t)-1`, like in the ordinary graph. */
+#define CLOWNLZSS_CHECKPOINT_FROM_LINK(link) ((link) == CLOWNLZSS_LINK_NONE ? (size_t)-1 : (size_t)(link))
+
+static void WriteCheckpoint(const Parameters* const parameters, const ClownLZSS_Settings* const settings, const ClownLZSS_GraphEdge* const node_meta_array)
+{
+	FieldWriter writer;
+	size_t header[CLOWNLZSS_CHECKPOINT_HEADER_FIELDS];
+	size_t i;
+
+	if (settings->write_checkpoint == NULL || !CanCheckpoint(parameters, settings))
+		return;
+
+	InitialiseFieldWriter(&writer, settings->write_checkpoint, settings->write_checkpoint_user, CLOWNLZSS_CHECKPOINT_MAGIC);
+
+	GetCheckpointHeader(parameters, settings, parameters->total_values, header);
+
+	for (i = 0; i < CLOWNLZSS_CHECKPOINT_HEADER_FIELDS; ++i)
+		PutField(&writer, header[i], CLOWNLZSS_CHECKPOINT_FIELD_BYTES);
+
+	FlushFields(&writer);
+	settings->write_checkpoint(parameters->data, parameters->total_values * parameters->bytes_per_value, settings->write_checkpoint_user);
+
+	/* The first node has no edge, so it has no previous node or match offset worth keeping. */
+	for (i = 0; i < parameters->total_values + 1; ++i)
+	{
+		if (parameters->compact_graph)
+		{
+			const CompactGraphEdge* const node = &((const CompactGraphEdge*)node_meta_array)[i];
+
+			PutField(&writer, CLOWNLZSS_CHECKPOINT_FROM_LINK(node->u.cost), CLOWNLZSS_CHECKPOINT_FIELD_BYTES);
+			PutField(&writer, i == 0 ? 0 : CLOWNLZSS_CHECKPOINT_FROM_LINK(node->previous_node_index), CLOWNLZSS_CHECKPOINT_FIELD_BYTES);
+			PutField(&writer, i == 0 ? 0 : CLOWNLZSS_CHECKPOINT_FROM_LINK(node->match_offset), CLOWNLZSS_CHECKPOINT_FIELD_BYTES);
+		}
+		else
+		{
+			PutField(&writer, node_meta_array[i].u.cost, CLOWNLZSS_CHECKPOINT_FIELD_BYTES);
+			PutField(&writer, i == 0 ? 0 : node_meta_array[i].previous_node_index, CLOWNLZSS_CHECKPOINT_FIELD_BYTES);
+			PutField(&writer, i == 0 ? 0 : node_meta_array[i].match_offset, CLOWNLZSS_CHECKPOINT_FIELD_BYTES);
+		}
+	}
+
+	FlushFields(&writer);
+}
+
+static size_t LoadCheckpoint(const Parameters* const parameters, const ClownLZSS_Settings* const settings, ClownLZSS_GraphEdge* const node_meta_array)
+{
+	const unsigned char* const checkpoint = settings->checkpoint;
+	const size_t checkpoint_size = settings->checkpoint_size;
+	const size_t bytes_per_value = parameters->bytes_per_value;
+	size_t header[CLOWNLZSS_CHECKPOINT_HEADER_FIELDS];
+	size_t i, old_total_values, data_bytes, nodes_start, total_kept_values;
+	const unsigned char *nodes;
+
+	if (checkpoint == NULL || !CanCheckpoint(parameters, settings) || checkpoint_size < CLOWNLZSS_CHECKPOINT_HEADER_BYTES
+	 || parameters->compare_bytes(checkpoint, (const unsigned char*)CLOWNLZSS_CHECKPOINT_MAGIC, CLOWNLZSS_MAGIC_BYTES) != CLOWNLZSS_MAGIC_BYTES)
+		return 0;
+
+	/* Everything but the size of the data must be the same as this parse. */
+	GetCheckpointHeader(parameters, settings, 0, header);
+
+	for (i = 0; i < CLOWNLZSS_CHECKPOINT_HEADER_FIELDS; ++i)
+	{
+		size_t field;
+
+		if (!GetField(&checkpoint[CLOWNLZSS_MAGIC_BYTES + i * CLOWNLZSS_CHECKPOINT_FIELD_BYTES], CLOWNLZSS_CHECKPOINT_FIELD_BYTES, &field))
+			return 0;
+
+		if (i == CLOWNLZSS_CHECKPOINT_HEADER_FIELDS - 1)
+			old_total_values = field;
+		else if (field != header[i])
+			return 0;
+	}
+
+	if (old_total_values > (checkpoint_size - CLOWNLZSS_CHECKPOINT_HEADER_BYTES) / bytes_per_value)
+		return 0;
+
+	data_bytes = old_total_values * bytes_per_value;
+	nodes_start = CLOWNLZSS_CHECKPOINT_HEADER_BYTES + data_bytes;
+
+	if ((checkpoint_size - nodes_start) / CLOWNLZSS_CHECKPOINT_NODE_BYTES != old_total_values + 1 || (checkpoint_size - nodes_start) % CLOWNLZSS_CHECKPOINT_NODE_BYTES != 0)
+		return 0;
+
+	/* The cost of reaching a node only depends on the values before it, so the nodes up to the first change are unaffected by it. */
+	total_kept_values = parameters->compare_bytes(&checkpoint[CLOWNLZSS_CHECKPOINT_HEADER_BYTES], parameters->data, CLOWNLZSS_MIN(old_total_values, parameters->total_values) * bytes_per_value) / bytes_per_value;
+
+	if (total_kept_values == 0)
+		return 0;
+
+	nodes = &checkpoint[nodes_start];
+
+	for (i = 0; i < total_kept_values + 1; ++i)
+	{
+		size_t fields[3];
+		unsigned int field;
+
+		for (field = 0; field < 3; ++field)
+		{
+			if (!GetField(&nodes[(i * 3 + field) * CLOWNLZSS_CHECKPOINT_FIELD_BYTES], CLOWNLZSS_CHECKPOINT_FIELD_BYTES, &fields[field]))
+				return 0;
+
+			/* The compact graph cannot hold positions that are this large. */
+			if (parameters->compact_graph && fields[field] != (size_t)-1 && fields[field] >= CLOWNLZSS_LINK_NONE)
+				return 0;
+		}
+
+		if (parameters->compact_graph)
+		{
+			CompactGraphEdge* const node = &((CompactGraphEdge*)node_meta_array)[i];
+
+			node->u.cost = fields[0] == (size_t)-1 ? CLOWNLZSS_LINK_NONE : (ClownLZSS_Link)fields[0];
+			node->previous_node_index = fields[1] == (size_t)-1 ? CLOWNLZSS_LINK_NONE : (ClownLZSS_Link)fields[1];
+			node->match_offset = fields[2] == (size_t)-1 ? CLOWNLZSS_LINK_NONE : (ClownLZSS_Link)fields[2];
+		}
+		else
+		{
+			node_meta_array[i].u.cost = fields[0];
+			node_meta_array[i].previous_node_index = fields[1];
+			node_meta_array[i].match_offset = fields[2];
+		}
+	}
+
+	return total_kept_values;
+}
+
+/*******\
+* Graph *
+\*******/
+
+typedef struct Layout
+{
+	/* Byte offsets into the workspace. The graph is always at the start of it. */
+	size_t cost_table;
+	size_t literal_runs;
+	size_t repeats;
+	size_t descriptor_graph;
+	size_t match_finder_buffer;
+	size_t padded_head;
+	size_t total_size;
+} Layout;
+
+static int AddToLayout(Layout* const layout, size_t* const offset, const size_t size)
+{
+	const size_t aligned_size = size + (CLOWNLZSS_WORKSPACE_ALIGNMENT - 1) - (size + (CLOWNLZSS_WORKSPACE_ALIGNMENT - 1)) % CLOWNLZSS_WORKSPACE_ALIGNMENT;
+
+	if (size > (size_t)-1 - (CLOWNLZSS_WORKSPACE_ALIGNMENT - 1) || aligned_size > (size_t)-1 - layout->total_size)
+		return 0;
+
+	*offset = layout->total_size;
+	layout->total_size += aligned_size;
+
+	return 1;
+}
+
+static int AddPaddedHeadToLayout(const Parameters* const parameters, Layout* const layout)
+{
+	const size_t size = GetPaddedHeadSize(parameters);
+
+	layout->padded_head = 0;
+
+	return parameters->padding == 0 || (size != 0 && AddToLayout(layout, &layout->padded_head, size));
+}
+
+static ClownLZSS_MatchFinder ChooseMatchFinder(const Parameters* const parameters, const ClownLZSS_Settings* const settings)
+{
+	/* The lazy parser only ever uses the hash-chains. */
+	if (settings->parser == CLOWNLZSS_PARSER_LAZY)
+		return CLOWNLZSS_MATCH_FINDER_HASH_CHAIN;
+	/* Without any hints or candidates, there would be nothing but literals. */
+	else if (settings->match_finder != CLOWNLZSS_MATCH_FINDER_AUTOMATIC && (settings->match_finder != CLOWNLZSS_MATCH_FINDER_HINTS || parameters->hints != NULL)
+	 && (settings->match_finder != CLOWNLZSS_MATCH_FINDER_CANDIDATES || parameters->candidates != NULL))
+		return settings->match_finder;
+	/* The candidates have already been searched for, so reading them is much faster than searching again. */
+	else if (parameters->candidates != NULL)
+		return CLOWNLZSS_MATCH_FINDER_CANDIDATES;
+	/* Only the hash-chains can be searched in parallel, unless the jobs are parsing whole blocks instead. Without an effort
+	   limit, every match finder produces the same matches, as long as the costs meet the requirements of the others. */
+	else if (settings->run_jobs != NULL && settings->total_jobs != 0 && settings->block_size == 0 && settings->maximum_chain_length == 0 && settings->nice_match_length == 0 && settings->good_match_length == 0)
+		return CLOWNLZSS_MATCH_FINDER_HASH_CHAIN;
+	/* With a large window, walking every string with the same hash gets expensive, so only visit the ones that can produce a longer match. */
+	else if (parameters->maximum_match_distance >= CLOWNLZSS_LARGE_WINDOW)
+		return CLOWNLZSS_MATCH_FINDER_BINARY_TREE;
+	else
+		return CLOWNLZSS_MATCH_FINDER_HASH_CHAIN;
+}
+
+static size_t GetMatchFinderBufferSize(const Parameters* const parameters, const ClownLZSS_MatchFinder match_finder)
+{
+	/* A size of 0 means that the match finder cannot handle this much data. */
+	switch (match_finder)
+	{
+		default:
+		case CLOWNLZSS_MATCH_FINDER_HASH_CHAIN:
+			return GetHashChainBufferSize(parameters);
+
+		case CLOWNLZSS_MATCH_FINDER_BINARY_TREE:
+			return GetBinaryTreeBufferSize(parameters);
+
+		case CLOWNLZSS_MATCH_FINDER_SUFFIX_ARRAY:
+			return GetSuffixArrayBufferSize(parameters);
+
+		case CLOWNLZSS_MATCH_FINDER_HINTS:
+		case CLOWNLZSS_MATCH_FINDER_CANDIDATES:
+			/* These need no buffer at all, but 0 would mean that they cannot be used. */
+			return 1;
+	}
+}
+
+static size_t GetLiteralRunCapacity(const ClownLZSS_Settings* const settings, const size_t total_values)
+{
+	return CLOWNLZSS_MAX(1, CLOWNLZSS_MIN(settings->literal_run_length_tiers[settings->total_literal_run_length_tiers - 1], total_values));
+}
+
+static int CanDeferLiteralRuns(const Parameters* const parameters, const ClownLZSS_Settings* const settings)
+{
+	const size_t longest_length = CLOWNLZSS_MIN(settings->literal_run_length_tiers[settings->total_literal_run_length_tiers - 1], CLOWNLZSS_MIN(parameters->maximum_match_length, parameters->total_values));
+	size_t tier;
+
+	/* The tiers must be in order, and a run must never cost 0, as that means that it cannot be encoded. */
+	for (tier = 0; tier < settings->total_literal_run_length_tiers; ++tier)
+		if ((tier != 0 && settings->literal_run_length_tiers[tier] <= settings->literal_run_length_tiers[tier - 1])
+		 || (settings->literal_run_header_costs[tier] == 0 && settings->literal_run_value_cost == 0))
+			return 0;
+
+	/* When a deferred run ties with an edge from the same source, it assumes that the edge came from the extra matches
+	   callback, so no match can cost the same as a run of the same length. Like the table, this is only checked at
+	   either end of each distance tier. */
+	if (parameters->cost_table == NULL)
+		return 0;
+
+	for (tier = 0; tier < settings->total_cost_distance_tiers; ++tier)
+	{
+		const size_t nearest_distance = tier == 0 ? 1 : settings->cost_distance_tiers[tier - 1] + 1;
+		const size_t furthest_distance = settings->cost_distance_tiers[tier];
+		size_t run_tier, length;
+
+		run_tier = 0;
+
+		for (length = 1; length <= longest_length; ++length)
+		{
+			size_t run_cost;
+
+			if (length > settings->literal_run_length_tiers[run_tier])
+				++run_tier;
+
+			run_cost = settings->literal_run_header_costs[run_tier] + settings->literal_run_value_cost * length;
+
+			if (GetMatchCost(parameters, nearest_distance, length) == run_cost || GetMatchCost(parameters, furthest_distance, length) == run_cost)
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void InitialiseLiteralRuns(LiteralRuns* const literal_runs, const ClownLZSS_Settings* const settings, const int deferred, size_t* const buffer, const size_t capacity, const size_t history)
+{
+	const size_t tiers = settings->total_literal_run_length_tiers;
+	size_t tier;
+
+	literal_runs->length_tiers = settings->literal_run_length_tiers;
+	literal_runs->header_costs = settings->literal_run_header_costs;
+	literal_runs->total_tiers = tiers;
+	literal_runs->value_cost = settings->literal_run_value_cost;
+	literal_runs->deferred = deferred;
+	literal_runs->capacity = capacity;
+	literal_runs->sources = buffer;
+	literal_runs->total_sources = 0;
+	literal_runs->queues = &buffer[capacity];
+	literal_runs->queue_starts = &buffer[capacity * (tiers + 1)];
+	literal_runs->queue_lengths = &literal_runs->queue_starts[tiers];
+	literal_runs->joined_sources = &literal_runs->queue_lengths[tiers];
+	/* The first node is where the parse begins, so there is nothing to resolve there. */
+	literal_runs->resolved_node = history;
+
+	for (tier = 0; tier < tiers; ++tier)
+	{
+		literal_runs->queue_starts[tier] = 0;
+		literal_runs->queue_lengths[tier] = 0;
+		literal_runs->joined_sources[tier] = 0;
+	}
+}
+
+static int GetLayout(const Parameters* const parameters, const ClownLZSS_Settings* const settings, const ClownLZSS_MatchFinder match_finder, Layout* const layout)
+{
+	const size_t match_finder_buffer_size = GetMatchFinderBufferSize(parameters, match_finder);
+	size_t graph;
+
+	layout->total_size = 0;
+	layout->cost_table = 0;
+	layout->literal_runs = 0;
+	layout->repeats = 0;
+	layout->descriptor_graph = 0;
+
+	if (match_finder_buffer_size == 0)
+		return 0;
+
+	/* +1 for the end-node */
+	if (parameters->total_values >= (size_t)-1 / sizeof(ClownLZSS_GraphEdge) || !AddToLayout(layout, &graph, (parameters->total_values + 1) * sizeof(ClownLZSS_GraphEdge)))
+		return 0;
+
+	if (settings->cost_distance_tiers != NULL && settings->total_cost_distance_tiers != 0)
+	{
+		const size_t entries_per_tier = parameters->cost_table_width;
+
+		if (settings->total_cost_distance_tiers > (size_t)-1 / sizeof(size_t) / entries_per_tier || !AddToLayout(layout, &layout->cost_table, settings->total_cost_distance_tiers * entries_per_tier * sizeof(size_t)))
+			return 0;
+	}
+
+	if (settings->total_literal_run_length_tiers != 0)
+	{
+		/* A ring buffer of sources, one queue of them per tier, and three counters per tier. */
+		const size_t capacity = GetLiteralRunCapacity(settings, parameters->total_values);
+		const size_t tiers = settings->total_literal_run_length_tiers;
+
+		if (capacity > (size_t)-1 - 3 || tiers >= (size_t)-1 / sizeof(size_t) / (capacity + 3) || !AddToLayout(layout, &layout->literal_runs, (capacity * (tiers + 1) + tiers * 3) * sizeof(size_t)))
+			return 0;
+	}
+
+	/* +1 for the end-node, like the graph. */
+	if (settings->maximum_repeat_match_length != 0 && !AddToLayout(layout, &layout->repeats, (parameters->total_values + 1) * sizeof(RepeatEdge)))
+		return 0;
+
+	/* Likewise, with a node for every fill of the field. */
+	if (parameters->descriptor_field_bits != 0
+	 && (parameters->total_values + 1 > (size_t)-1 / sizeof(ClownLZSS_GraphEdge) / parameters->descriptor_field_bits
+	  || !AddToLayout(layout, &layout->descriptor_graph, (parameters->total_values + 1) * parameters->descriptor_field_bits * sizeof(ClownLZSS_GraphEdge))))
+		return 0;
+
+	return AddToLayout(layout, &layout->match_finder_buffer, match_finder_buffer_size)
+		&& AddPaddedHeadToLayout(parameters, layout);
+}
+
+static void ParseGraph(const Parameters* const parameters, const ClownLZSS_MatchFinder match_finder, ClownLZSS_GraphEdge* const node_meta_array, void* const match_finder_buffer)
+{
+	size_t i;
+
+	/* Set costs to maximum possible value, so later comparisons work, except for the nodes that were kept from a checkpoint. */
+	if (parameters->compact_graph)
+	{
+		CompactGraphEdge* const graph = (CompactGraphEdge*)node_meta_array;
+
+		if (parameters->kept_nodes == 0)
+			graph[parameters->history].u.cost = 0;
+
+		for (i = CLOWNLZSS_MAX(parameters->history + 1, parameters->kept_nodes); i < parameters->total_values + 1; ++i)
+			graph[i].u.cost = CLOWNLZSS_LINK_NONE;
+	}
+	else
+	{
+		if (parameters->kept_nodes == 0)
+			node_meta_array[parameters->history].u.cost = 0;
+
+		for (i = CLOWNLZSS_MAX(parameters->history + 1, parameters->kept_nodes); i < parameters->total_values + 1; ++i)
+			node_meta_array[i].u.cost = CLOWNLZSS_GRAPH_DUMMY;
+
+		/* The first node has no edge, so give it one that matches its distance. The others have none yet either, so
+		   that a distance that was left behind by an earlier use of the workspace is never mistaken for theirs. */
+		if (parameters->repeats != NULL)
+		{
+			node_meta_array[parameters->history].previous_node_index = CLOWNLZSS_GRAPH_DUMMY;
+			parameters->repeats[parameters->history].distance = parameters->repeat_distance;
+
+			for (i = parameters->history; i < parameters->total_values + 1; ++i)
+				parameters->repeats[i].source = CLOWNLZSS_GRAPH_DUMMY;
+		}
+
+		/* The parse begins with an empty field. */
+		if (parameters->descriptor_graph != NULL)
+		{
+			for (i = parameters->history * parameters->descriptor_field_bits; i < (parameters->total_values + 1) * parameters->descriptor_field_bits; ++i)
+				parameters->descriptor_graph[i].u.cost = CLOWNLZSS_GRAPH_DUMMY;
+
+			parameters->descriptor_graph[parameters->history * parameters->descriptor_field_bits].u.cost = 0;
+		}
+	}
+
+	/* Search for matches, to populate the edges of the LZSS graph.
+	   Notably, while doing this, we're also using a shortest-path
+	   algorithm on the edges to find the best combination of matches
+	   to produce the smallest file. */
+	if (parameters->parser == CLOWNLZSS_PARSER_LAZY)
+	{
+		ParseLazy(parameters, node_meta_array, NULL, match_finder_buffer);
+	}
+	else
+	{
+		switch (match_finder)
+		{
+			default:
+			case CLOWNLZSS_MATCH_FINDER_HASH_CHAIN:
+				FindMatchesHashChain(parameters, node_meta_array, match_finder_buffer);
+				break;
+
+			case CLOWNLZSS_MATCH_FINDER_BINARY_TREE:
+				FindMatchesBinaryTree(parameters, node_meta_array, match_finder_buffer);
+				break;
+
+			case CLOWNLZSS_MATCH_FINDER_SUFFIX_ARRAY:
+				FindMatchesSuffixArray(parameters, node_meta_array, match_finder_buffer);
+				break;
+
+			case CLOWNLZSS_MATCH_FINDER_HINTS:
+				FindMatchesHints(parameters, node_meta_array);
+				break;
+
+			case CLOWNLZSS_MATCH_FINDER_CANDIDATES:
+				FindMatchesCandidates(parameters, node_meta_array);
+				break;
+		}
+	}
+
+	/* The end of the parse is not visited, so the runs to it may not have been resolved yet. */
+	ResolveLiteralRuns(parameters, node_meta_array, parameters->parse_end);
+}
+
+static void TraceDescriptorGraph(const Parameters* const parameters, const ClownLZSS_Settings* const settings, ClownLZSS_GraphEdge* const node_meta_array)
+{
+	const size_t field_bits = parameters->descriptor_field_bits;
+	size_t best_size, node, fill;
+
+	best_size = CLOWNLZSS_GRAPH_DUMMY;
+	node = parameters->parse_end * field_bits;
+
+	/* Only at the end is it known how many fields are written, as the trailing bits may spill into another one. So, round
+	   each fill's bits up to whole fields, and take the smallest. The fill is never more than the descriptor bits so far. */
+	for (fill = 0; fill < field_bits; ++fill)
+	{
+		const size_t cost = parameters->descriptor_graph[parameters->parse_end * field_bits + fill].u.cost;
+		const size_t bits = fill + settings->trailing_descriptor_bits;
+		const size_t fields = settings->descriptor_field_written_when_full ? bits / field_bits + 1 : (bits + field_bits - 1) / field_bits;
+
+		if (cost != CLOWNLZSS_GRAPH_DUMMY && cost - fill + fields * field_bits < best_size)
+		{
+			best_size = cost - fill + fields * field_bits;
+			node = parameters->parse_end * field_bits + fill;
+		}
+	}
+
+	/* Copy the shortest path to the ordinary graph, so that the matches can be produced from it as usual. */
+	while (node / field_bits != parameters->history)
+	{
+		const size_t previous_node = parameters->descriptor_graph[node].previous_node_index;
+
+		node_meta_array[node / field_bits].previous_node_index = previous_node / field_bits;
+		node_meta_array[node / field_bits].match_offset = parameters->descriptor_graph[node].match_offset;
+
+		node = previous_node;
+	}
+}
+
+static size_t ProduceCompactMatches(CompactGraphEdge* const graph, const size_t start, const size_t end)
+{
+	/* The same as below, except that the matches are also compact at first, and are widened afterwards. */
+	CompactMatch* const compact_matches = (CompactMatch*)graph;
+	ClownLZSS_Match* const matches = (ClownLZSS_Match*)graph;
+	size_t total_matches;
+	size_t i;
+
+	graph[start].previous_node_index = CLOWNLZSS_LINK_NONE;
+	graph[end].u.next_node_index = CLOWNLZSS_LINK_NONE;
+
+	for (i = end; graph[i].previous_node_index != CLOWNLZSS_LINK_NONE; i = graph[i].previous_node_index)
+		graph[graph[i].previous_node_index].u.next_node_index = (ClownLZSS_Link)i;
+
+	total_matches = 0;
+
+	i = start;
+	while (graph[i].u.next_node_index != CLOWNLZSS_LINK_NONE)
+	{
+		const size_t next_index = graph[i].u.next_node_index;
+
+		compact_matches[total_matches].source = graph[next_index].match_offset;
+		compact_matches[total_matches].destination = (ClownLZSS_Link)i;
+		compact_matches[total_matches].length = (ClownLZSS_Link)(next_index - i);
+
+		++total_matches;
+
+		i = next_index;
+	}
+
+	/* Widen the matches from the last to the first, so that each one is read before anything is written over it.
+	   The graph's memory is large enough for a full-size node per value, so there is always room. */
+	for (i = total_matches; i-- != 0; )
+	{
+		const CompactMatch match = compact_matches[i];
+
+		/* A match that begins in the filler values has a source that wrapped around below 0, which would be wrong if it
+		   were only zero-extended, so the distance is worked out first, while it is still 32-bit. Literals have a source
+		   just after their destination instead. */
+		if (match.source == match.destination + 1)
+			matches[i].source = (size_t)match.destination + 1;
+		else
+			matches[i].source = (size_t)match.destination - (ClownLZSS_Link)(match.destination - match.source);
+		matches[i].destination = match.destination;
+		matches[i].length = match.length;
+	}
+
+	return total_matches;
+}
+
+static size_t ProduceMatches(const Parameters* const parameters, ClownLZSS_GraphEdge* const node_meta_array, const size_t start, const size_t end)
+{
+	/* It's safe to overwrite the LZSS graph with the matches, as each match is written no further than the node that it was read from. */
+	ClownLZSS_Match* const matches = (ClownLZSS_Match*)node_meta_array;
+	size_t total_matches;
+	size_t i;
+
+	if (parameters->compact_graph)
+		return ProduceCompactMatches((CompactGraphEdge*)node_meta_array, start, end);
+
+	/* At this point, the edges will have formed a shortest-path from the start to the end:
+	   You just have to start at the last edge, and follow it backwards all the way to the start. */
+
+	/* Mark start/end nodes for the following loops */
+	node_meta_array[start].previous_node_index = CLOWNLZSS_GRAPH_DUMMY;
+	node_meta_array[end].u.next_node_index = CLOWNLZSS_GRAPH_DUMMY;
+
+	/* Reverse the direction of the edges, so we can parse the LZSS graph from start to end */
+	for (i = end; node_meta_array[i].previous_node_index != CLOWNLZSS_GRAPH_DUMMY; i = node_meta_array[i].previous_node_index)
+		node_meta_array[node_meta_array[i].previous_node_index].u.next_node_index = i;
+
+	total_matches = 0;
+
+	i = start;
+	while (node_meta_array[i].u.next_node_index != CLOWNLZSS_GRAPH_DUMMY)
+	{
+		const size_t next_index = node_meta_array[i].u.next_node_index;
+		const size_t offset = node_meta_array[next_index].match_offset;
+
+		matches[total_matches].source = offset;
+		matches[total_matches].destination = i;
+		matches[total_matches].length = next_index - i;
+
+		++total_matches;
+
+		i = next_index;
+	}
+
+	return total_matches;
+}
+
+static int InitialiseParameters(
+	Parameters* const parameters,
+	const ClownLZSS_Settings* const settings,
+	const int filler_value,
+	const size_t maximum_match_length,
+	const size_t maximum_match_distance,
+	void (* const extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user),
+	const size_t literal_cost,
+	size_t (* const match_cost_callback)(size_t distance, size_t length, void *user),
+	const unsigned char* const data,
+	const size_t bytes_per_value,
+	const size_t total_values,
+	const void* const user
+)
+{
+	/* The window links are only 32-bit. */
+	if (maximum_match_distance == 0 || maximum_match_distance > 0xFFFFFFFF || bytes_per_value == 0)
+		return 0;
+
+	parameters->filler_value = filler_value;
+	parameters->maximum_match_length = maximum_match_length;
+	parameters->maximum_match_distance = maximum_match_distance;
+	parameters->extra_matches_callback = extra_matches_callback;
+	parameters->extra_run_matches_callback = settings->extra_run_matches_callback;
+	parameters->literal_cost = literal_cost;
+	parameters->match_cost_callback = match_cost_callback;
+	parameters->data = data;
+	parameters->bytes_per_value = bytes_per_value;
+	parameters->total_values = total_values;
+	parameters->user = (void*)user;
+	/* The cost table is filled-in once the workspace is ready. */
+	parameters->cost_table = NULL;
+	parameters->cost_table_width = CLOWNLZSS_MIN(maximum_match_length, CLOWNLZSS_MAXIMUM_TABULATED_LENGTH) + 1;
+	parameters->cost_distance_tiers = settings->cost_distance_tiers;
+	parameters->cost_tail_period = 0;
+	parameters->minimum_match_length = GetMinimumUsefulMatchLength(parameters, CLOWNLZSS_MAX(1, CLOWNLZSS_MAXIMUM_KEY_BYTES / bytes_per_value));
+	parameters->maximum_extra_match_length = 0;
+	parameters->padding = filler_value == -1 ? 0 : maximum_match_distance;
+	/* The copy of the filler values is made once the workspace is ready. */
+	parameters->padded_head = NULL;
+	parameters->history = 0;
+	parameters->parse_end = total_values;
+	parameters->kept_nodes = 0;
+	parameters->cut_points = NULL;
+	parameters->hints = NULL;
+	parameters->total_hints = 0;
+	parameters->hint_cursor = NULL;
+	parameters->candidates = NULL;
+	parameters->candidates_size = 0;
+	parameters->literal_runs = NULL;
+	parameters->repeats = NULL;
+	parameters->maximum_repeat_match_length = settings->maximum_repeat_match_length;
+	parameters->repeat_match_cost = settings->repeat_match_cost;
+	parameters->repeat_distance = 0;
+	parameters->descriptor_graph = NULL;
+	parameters->descriptor_field_bits = 0;
+	parameters->run_end = NULL;
+	parameters->parser = settings->parser;
+	parameters->run_jobs = NULL;
+	parameters->run_jobs_user = NULL;
+	parameters->total_jobs = 0;
+	parameters->maximum_chain_length = settings->maximum_chain_length == 0 ? (size_t)-1 : settings->maximum_chain_length;
+	parameters->nice_match_length = settings->nice_match_length == 0 ? (size_t)-1 : settings->nice_match_length;
+	parameters->good_match_length = settings->good_match_length == 0 ? (size_t)-1 : settings->good_match_length;
+	parameters->compare_bytes = ChooseCompareBytes();
+	/* The literals are the most that any position can cost, so if every literal fits, then every cost does. */
+	parameters->compact_graph = sizeof(CompactGraphEdge) < sizeof(ClownLZSS_GraphEdge) && !HasExtraMatches(parameters) && settings->total_literal_run_length_tiers == 0 && settings->maximum_repeat_match_length == 0 && total_values < CLOWNLZSS_LINK_NONE && literal_cost < CLOWNLZSS_LINK_NONE / (total_values + 1);
+
+	return 1;
+}
+
+static void InitialiseDescriptorFields(Parameters* const parameters, const ClownLZSS_Settings* const settings)
+{
+	/* Only whole data is parsed this way, as it needs the rest of the parse to be in one graph too. */
+	if (!settings->exact_size || settings->descriptor_field_bits == 0 || settings->total_literal_run_length_tiers != 0 || settings->maximum_repeat_match_length != 0
+	 || (HasExtraMatches(parameters) && settings->maximum_extra_match_length == 0))
+		return;
+
+	parameters->descriptor_field_bits = settings->descriptor_field_bits;
+	parameters->maximum_extra_match_length = settings->maximum_extra_match_length;
+	/* The ordinary graph is needed at full size, to collect the callback's edges in. */
+	parameters->compact_graph = 0;
+}
+
+static void InitialiseHints(Parameters* const parameters, const ClownLZSS_Settings* const settings)
+{
+	/* The hints are positions in the whole data, which the windows of the streams and blocks are not. */
+	if (settings->hints == NULL || settings->total_hints == 0)
+		return;
+
+	parameters->hints = settings->hints;
+	parameters->total_hints = settings->total_hints;
+}
+
+static void InitialiseJobs(Parameters* const parameters, const ClownLZSS_Settings* const settings, const ClownLZSS_MatchFinder match_finder)
+{
+	/* The lazy parser searches the chains its own way, and the stream would need room for every link. */
+	if (settings->run_jobs == NULL || settings->total_jobs == 0 || match_finder != CLOWNLZSS_MATCH_FINDER_HASH_CHAIN || parameters->parser != CLOWNLZSS_PARSER_OPTIMAL)
+		return;
+
+	parameters->run_jobs = settings->run_jobs;
+	parameters->run_jobs_user = settings->run_jobs_user;
+	parameters->total_jobs = settings->total_jobs;
+}
+
+static void InitialiseSettings(ClownLZSS_Settings* const settings)
+{
+	settings->parser = CLOWNLZSS_PARSER_OPTIMAL;
+	settings->match_finder = CLOWNLZSS_MATCH_FINDER_AUTOMATIC;
+	settings->cost_distance_tiers = NULL;
+	settings->total_cost_distance_tiers = 0;
+	settings->literal_run_length_tiers = NULL;
+	settings->literal_run_header_costs = NULL;
+	settings->total_literal_run_length_tiers = 0;
+	settings->literal_run_value_cost = 0;
+	settings->maximum_repeat_match_length = 0;
+	settings->repeat_match_cost = 0;
+	settings->descriptor_field_bits = 0;
+	settings->trailing_descriptor_bits = 0;
+	settings->descriptor_field_written_when_full = 0;
+	settings->maximum_extra_match_length = 0;
+	settings->exact_size = 0;
+	settings->extra_run_matches_callback = NULL;
+	settings->run_jobs = NULL;
+	settings->run_jobs_user = NULL;
+	settings->total_jobs = 0;
+	settings->block_size = 0;
+	settings->hints = NULL;
+	settings->total_hints = 0;
+	settings->candidates = NULL;
+	settings->candidates_size = 0;
+	settings->checkpoint = NULL;
+	settings->checkpoint_size = 0;
+	settings->write_checkpoint = NULL;
+	settings->write_checkpoint_user = NULL;
+	settings->horizon = 0;
+	settings->maximum_chain_length = 0;
+	settings->nice_match_length = 0;
+	settings->good_match_length = 0;
+}
+
+void ClownLZSS_InitialiseSettings(ClownLZSS_Settings* const settings)
+{
+	InitialiseSettings(settings);
+}
+
+void ClownLZSS_SetEffortLevel(ClownLZSS_Settings* const settings, const unsigned int level)
+{
+	/* Maximum chain length, nice match length, and good match length. */
+	static const size_t levels[9][3] = {
+		{   4,   8,   8},
+		{   8,  16,  16},
+		{  16,  24,  24},
+		{  32,  32,  32},
+		{  64,  64,  64},
+		{ 128, 128, 128},
+		{ 512, 256, 256},
+		{2048,   0, 512},
+		{   0,   0,   0}
+	};
+
+	const size_t* const effort = levels[CLOWNLZSS_MIN(CLOWNLZSS_MAX(level, 1), 9) - 1];
+
+	settings->maximum_chain_length = effort[0];
+	settings->nice_match_length = effort[1];
+	settings->good_match_length = effort[2];
+}
+
+size_t ClownLZSS_GetWorkspaceSize(
+	const ClownLZSS_Settings* const settings,
+	const int filler_value,
+	const size_t maximum_match_length,
+	const size_t maximum_match_distance,
+	const size_t literal_cost,
+	size_t (* const match_cost_callback)(size_t distance, size_t length, void *user),
+	const size_t bytes_per_value,
+	const size_t total_values,
+	const void* const user
+)
+{
+	Parameters parameters;
+	ClownLZSS_MatchFinder match_finder;
+	Layout layout;
+
+	if (total_values == 0)
+		return 0;
+
+	if (!InitialiseParameters(&parameters, settings, filler_value, maximum_match_length, maximum_match_distance, NULL, literal_cost, match_cost_callback, NULL, bytes_per_value, total_values, user))
+		return (size_t)-1;
+
+	InitialiseDescriptorFields(&parameters, settings);
+	InitialiseHints(&parameters, settings);
+	InitialiseCandidates(&parameters, settings);
+
+	match_finder = ChooseMatchFinder(&parameters, settings);
+	InitialiseJobs(&parameters, settings, match_finder);
+
+	if (!GetLayout(&parameters, settings, match_finder, &layout))
+		return (size_t)-1;
+
+	return layout.total_size;
+}
+
+int ClownLZSS_FindOptimalMatchesWithWorkspace(
+	ClownLZSS_Workspace* const workspace,
+	const ClownLZSS_Settings* const settings,
+	const int filler_value,
+	const size_t maximum_match_length,
+	const size_t maximum_match_distance,
+	void (* const extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user),
+	const size_t literal_cost,
+	size_t (* const match_cost_callback)(size_t distance, size_t length, void *user),
+	const unsigned char* const data,
+	const size_t bytes_per_value,
+	const size_t total_values,
+	ClownLZSS_Match** const _matches,
+	size_t* const _total_matches,
+	const void* const user
+)
+{
+	Parameters parameters;
+	ClownLZSS_MatchFinder match_finder;
+	Layout layout;
+	LiteralRuns literal_runs;
+	size_t run_end;
+	HintCursor hint_cursor;
+	unsigned char *buffer;
+	ClownLZSS_GraphEdge *node_meta_array;
+	ClownLZSS_Match *matches;
+	size_t total_matches, total_kept_values, i;
+
+	/* Handle the edge-case where the data is empty. */
+	if (total_values == 0)
+	{
+		*_matches = NULL;
+		*_total_matches = 0;
+		return 1;
+	}
+
+	if (!InitialiseParameters(&parameters, settings, filler_value, maximum_match_length, maximum_match_distance, extra_matches_callback, literal_cost, match_cost_callback, data, bytes_per_value, total_values, user))
+		return 0;
+
+	InitialiseDescriptorFields(&parameters, settings);
+	InitialiseHints(&parameters, settings);
+	InitialiseCandidates(&parameters, settings);
+
+	match_finder = ChooseMatchFinder(&parameters, settings);
+	InitialiseJobs(&parameters, settings, match_finder);
+
+	if (!GetLayout(&parameters, settings, match_finder, &layout))
+		return 0;
+
+	buffer = (unsigned char*)ClownLZSS_ReserveWorkspace(workspace, layout.total_size);
+
+	if (buffer == NULL)
+		return 0;
+
+	node_meta_array = (ClownLZSS_GraphEdge*)buffer;
+
+	if (settings->cost_distance_tiers != NULL && settings->total_cost_distance_tiers != 0)
+	{
+		parameters.cost_table = BuildCostTable(&parameters, settings->total_cost_distance_tiers, (size_t*)&buffer[layout.cost_table]);
+		FindCostTail(&parameters, settings->total_cost_distance_tiers);
+	}
+
+	if (settings->total_literal_run_length_tiers != 0)
+	{
+		InitialiseLiteralRuns(&literal_runs, settings, CanDeferLiteralRuns(&parameters, settings), (size_t*)&buffer[layout.literal_runs], GetLiteralRunCapacity(settings, total_values), 0);
+		parameters.literal_runs = &literal_runs;
+	}
+
+	if (settings->maximum_repeat_match_length != 0)
+		parameters.repeats = (RepeatEdge*)&buffer[layout.repeats];
+
+	if (parameters.descriptor_field_bits != 0)
+		parameters.descriptor_graph = (ClownLZSS_GraphEdge*)&buffer[layout.descriptor_graph];
+
+	if (parameters.padding != 0)
+		InitialisePaddedHead(&parameters, &buffer[layout.padded_head]);
+
+	run_end = 0;
+	parameters.run_end = &run_end;
+
+	hint_cursor.next_hint = 0;
+
+	for (i = 0; i < CLOWNLZSS_TOTAL_RECENT_HINT_DISTANCES; ++i)
+		hint_cursor.recent_distances[i] = 0;
+	parameters.hint_cursor = &hint_cursor;
+
+	/* The nodes before a change to the data keep their cheapest paths, so the parse only has to begin a match before it, which is
+	   as far back as a node after the change can be reached from. */
+	total_kept_values = LoadCheckpoint(&parameters, settings, node_meta_array);
+
+	if (total_kept_values != 0)
+	{
+		parameters.history = total_kept_values - CLOWNLZSS_MIN(total_kept_values, CLOWNLZSS_MAX(CLOWNLZSS_MAX(maximum_match_length, settings->maximum_extra_match_length), 1));
+		parameters.kept_nodes = total_kept_values + 1;
+	}
+
+	/* Produce an array of LZSS matches for the caller to process. */
+	matches = (ClownLZSS_Match*)node_meta_array;
+
+	if (CanEmitLazyMatches(&parameters))
+	{
+		/* The graph's memory is large enough for a full-size node per value, so there is room for a literal per value. */
+		total_matches = ParseLazy(&parameters, NULL, matches, &buffer[layout.match_finder_buffer]);
+	}
+	else
+	{
+		ParseGraph(&parameters, match_finder, node_meta_array, &buffer[layout.match_finder_buffer]);
+
+		if (parameters.descriptor_graph != NULL)
+			TraceDescriptorGraph(&parameters, settings, node_meta_array);
+
+		WriteCheckpoint(&parameters, settings, node_meta_array);
+
+		total_matches = ProduceMatches(&parameters, node_meta_array, 0, total_values);
+	}
+
+	*_matches = matches;
+	*_total_matches = total_matches;
+
+	return 1;
+}
+
+/********\
+* Stream *
+\********/
+
+static int GetStreamLayout(
+	Parameters* const parameters,
+	const ClownLZSS_Settings* const settings,
+	const int filler_value,
+	const size_t maximum_match_length,
+	const size_t maximum_match_distance,
+	const size_t maximum_extra_match_length,
+	const size_t literal_cost,
+	size_t (* const match_cost_callback)(size_t distance, size_t length, void *user),
+	const size_t bytes_per_value,
+	const void* const user,
+	ClownLZSS_MatchFinder* const match_finder,
+	Layout* const layout,
+	size_t* const window
+)
+{
+	/* Enough values after the horizon for any match that starts before it, unless matches can be longer than the horizon. */
+	const size_t longest_literal_run = settings->total_literal_run_length_tiers != 0 ? settings->literal_run_length_tiers[settings->total_literal_run_length_tiers - 1] : 0;
+	const size_t lookahead = CLOWNLZSS_MIN(CLOWNLZSS_MAX(CLOWNLZSS_MAX(maximum_match_length, maximum_extra_match_length), longest_literal_run), settings->horizon);
+	size_t capacity;
+
+	if (settings->horizon == 0 || maximum_match_distance > (size_t)-1 - settings->horizon || lookahead > (size_t)-1 - maximum_match_distance - settings->horizon)
+		return 0;
+
+	capacity = maximum_match_distance + settings->horizon + lookahead;
+
+	if (!InitialiseParameters(parameters, settings, filler_value, maximum_match_length, maximum_match_distance, NULL, literal_cost, match_cost_callback, NULL, bytes_per_value, capacity, user))
+		return 0;
+
+	parameters->maximum_extra_match_length = maximum_extra_match_length;
+
+	/* The first part of the data needs the most memory, as it is the only part with filler values before it. */
+	*match_finder = ChooseMatchFinder(parameters, settings);
+
+	return GetLayout(parameters, settings, *match_finder, layout)
+		&& capacity <= (size_t)-1 / bytes_per_value
+		&& AddToLayout(layout, window, capacity * bytes_per_value);
+}
+
+static void ParseStreamBlock(ClownLZSS_Stream* const stream)
+{
+	const size_t horizon = stream->settings.horizon;
+
+	Parameters parameters;
+	CutPoints cut_points;
+	LiteralRuns literal_runs;
+	size_t run_end, cut, total_matches, new_history, dropped, i;
+
+	/* There are only filler values before the very start of the data. */
+	InitialiseParameters(&parameters, &stream->settings, stream->position == 0 ? stream->filler_value : -1, stream->maximum_match_length, stream->maximum_match_distance, stream->extra_matches_callback, stream->literal_cost, stream->match_cost_callback, stream->buffer, stream->bytes_per_value, stream->total_buffered, stream->user);
+	parameters.maximum_extra_match_length = stream->maximum_extra_match_length;
+	parameters.cost_table = stream->cost_table;
+	parameters.cost_tail_length = stream->cost_tail_length;
+	parameters.cost_tail_period = stream->cost_tail_period;
+	parameters.cost_tail_step = stream->cost_tail_step;
+	parameters.history = stream->history;
+	parameters.parse_end = CLOWNLZSS_MIN(stream->history + horizon, stream->total_buffered);
+	parameters.cut_points = &cut_points;
+	parameters.run_end = &run_end;
+	parameters.repeats = (RepeatEdge*)stream->repeats;
+	parameters.repeat_distance = stream->repeat_distance;
+
+	/* More of the start of the data may have arrived since the last part, so the copy is made again. */
+	if (parameters.padding != 0)
+		InitialisePaddedHead(&parameters, stream->padded_head);
+
+	cut_points.furthest_edge = cut_points.last_cut_point = stream->history;
+	run_end = stream->history;
+
+	if (stream->settings.total_literal_run_length_tiers != 0)
+	{
+		InitialiseLiteralRuns(&literal_runs, &stream->settings, stream->literal_runs_deferred, stream->literal_run_buffer, GetLiteralRunCapacity(&stream->settings, stream->capacity), stream->history);
+		parameters.literal_runs = &literal_runs;
+	}
+
+	ParseGraph(&parameters, stream->match_finder, stream->graph, stream->match_finder_buffer);
+
+	/* If nothing reaches past the horizon, then the path up to it is settled. Otherwise, settle the path up to the last point
+	   that every path goes through, unless that would leave too much of the horizon to be parsed again, in which case the
+	   path is cut at the horizon, and the output may not be optimal. */
+	if (parameters.parse_end == stream->total_buffered || cut_points.furthest_edge <= parameters.parse_end)
+		cut = parameters.parse_end;
+	else if (cut_points.last_cut_point - stream->history >= (horizon + 1) / 2)
+		cut = cut_points.last_cut_point;
+	else
+		cut = parameters.parse_end;
+
+	/* The next part carries on from the distance that the path leaves behind. */
+	if (parameters.repeats != NULL)
+		stream->repeat_distance = GetRepeatDistance(&parameters, stream->graph, cut);
+
+	total_matches = ProduceMatches(&parameters, stream->graph, stream->history, cut);
+	stream->matches_callback(stream->buffer, stream->position, (const ClownLZSS_Match*)stream->graph, total_matches, stream->matches_callback_user);
+
+	/* Slide the window along, keeping only what later values can match. */
+	new_history = CLOWNLZSS_MIN(stream->maximum_match_distance, stream->position + cut);
+	dropped = cut - new_history;
+
+	for (i = 0; i < (stream->total_buffered - dropped) * stream->bytes_per_value; ++i)
+		stream->buffer[i] = stream->buffer[dropped * stream->bytes_per_value + i];
+
+	stream->total_buffered -= dropped;
+	stream->position += dropped;
+	stream->history = new_history;
+}
+
+size_t ClownLZSS_GetStreamWorkspaceSize(
+	const ClownLZSS_Settings* const settings,
+	const int filler_value,
+	const size_t maximum_match_length,
+	const size_t maximum_match_distance,
+	const size_t maximum_extra_match_length,
+	const size_t literal_cost,
+	size_t (* const match_cost_callback)(size_t distance, size_t length, void *user),
+	const size_t bytes_per_value,
+	const void* const user
+)
+{
+	Parameters parameters;
+	ClownLZSS_MatchFinder match_finder;
+	Layout layout;
+	size_t window;
+
+	if (!GetStreamLayout(&parameters, settings, filler_value, maximum_match_length, maximum_match_distance, maximum_extra_match_length, literal_cost, match_cost_callback, bytes_per_value, user, &match_finder, &layout, &window))
+		return (size_t)-1;
+
+	return layout.total_size;
+}
+
+int ClownLZSS_BeginStream(
+	ClownLZSS_Stream* const stream,
+	ClownLZSS_Workspace* const workspace,
+	const ClownLZSS_Settings* const settings,
 	const int filler_value,
 	const size_t maximum_match_length,
 	const size_t maximum_match_distance,
 	void (* const extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user),
+	const size_t maximum_extra_match_length,
+	const size_t literal_cost,
+	size_t (* const match_cost_callback)(size_t distance, size_t length, void *user),
+	const size_t bytes_per_value,
+	void (* const matches_callback)(const unsigned char *data, size_t position, const ClownLZSS_Match *matches, size_t total_matches, void *user),
+	void* const matches_callback_user,
+	const void* const user
+)
+{
+	Parameters parameters;
+	Layout layout;
+	size_t window;
+	unsigned char *buffer;
+
+	if (!GetStreamLayout(&parameters, settings, filler_value, maximum_match_length, maximum_match_distance, maximum_extra_match_length, literal_cost, match_cost_callback, bytes_per_value, user, &stream->match_finder, &layout, &window))
+		return 0;
+
+	buffer = (unsigned char*)ClownLZSS_ReserveWorkspace(workspace, layout.total_size);
+
+	if (buffer == NULL)
+		return 0;
+
+	stream->settings = *settings;
+	stream->filler_value = filler_value;
+	stream->maximum_match_length = maximum_match_length;
+	stream->maximum_match_distance = maximum_match_distance;
+	stream->extra_matches_callback = extra_matches_callback;
+	stream->maximum_extra_match_length = maximum_extra_match_length;
+	stream->literal_cost = literal_cost;
+	stream->match_cost_callback = match_cost_callback;
+	stream->bytes_per_value = bytes_per_value;
+	stream->matches_callback = matches_callback;
+	stream->matches_callback_user = matches_callback_user;
+	stream->user = user;
+
+	/* The costs do not depend on the data, so the table is shared by every part of it. */
+	stream->graph = (ClownLZSS_GraphEdge*)buffer;
+	stream->cost_table = NULL;
+	stream->match_finder_buffer = &buffer[layout.match_finder_buffer];
+	stream->padded_head = &buffer[layout.padded_head];
+
+	if (settings->cost_distance_tiers != NULL && settings->total_cost_distance_tiers != 0)
+	{
+		stream->cost_table = parameters.cost_table = BuildCostTable(&parameters, settings->total_cost_distance_tiers, (size_t*)&buffer[layout.cost_table]);
+		FindCostTail(&parameters, settings->total_cost_distance_tiers);
+	}
+
+	stream->cost_tail_length = parameters.cost_tail_length;
+	stream->cost_tail_period = parameters.cost_tail_period;
+	stream->cost_tail_step = parameters.cost_tail_step;
+
+	stream->literal_run_buffer = (size_t*)&buffer[layout.literal_runs];
+	stream->repeats = settings->maximum_repeat_match_length != 0 ? &buffer[layout.repeats] : NULL;
+	stream->repeat_distance = 0;
+	stream->literal_runs_deferred = settings->total_literal_run_length_tiers != 0 && CanDeferLiteralRuns(&parameters, settings);
+
+	stream->buffer = &buffer[window];
+	stream->capacity = parameters.total_values;
+	stream->total_buffered = 0;
+	stream->history = 0;
+	stream->position = 0;
+
+	return 1;
+}
+
+void ClownLZSS_WriteStream(ClownLZSS_Stream* const stream, const unsigned char *data, size_t total_values)
+{
+	while (total_values != 0)
+	{
+		const size_t values_to_copy = CLOWNLZSS_MIN(total_values, stream->capacity - stream->total_buffered);
+		const size_t bytes_to_copy = values_to_copy * stream->bytes_per_value;
+		unsigned char* const destination = &stream->buffer[stream->total_buffered * stream->bytes_per_value];
+		size_t i;
+
+		for (i = 0; i < bytes_to_copy; ++i)
+			destination[i] = data[i];
+
+		data += bytes_to_copy;
+		total_values -= values_to_copy;
+		stream->total_buffered += values_to_copy;
+
+		/* Nothing can be parsed until there is enough data after the horizon to find the longest match. */
+		while (stream->total_buffered == stream->capacity)
+			ParseStreamBlock(stream);
+	}
+}
+
+void ClownLZSS_EndStream(ClownLZSS_Stream* const stream)
+{
+	while (stream->history != stream->total_buffered)
+		ParseStreamBlock(stream);
+}
+
+/********\
+* Blocks *
+\********/
+
+typedef struct BlockJobs
+{
+	const ClownLZSS_Settings *settings;
+	/* Sized for the largest block, and holds what every block shares. */
+	const Parameters *parameters;
+	ClownLZSS_MatchFinder match_finder;
+	int literal_runs_deferred;
+	/* Each job has a whole layout's worth of the buffer, and puts the number of matches that it found at this offset. */
+	const Layout *layout;
+	size_t total_matches;
+	unsigned char *buffer;
+	int filler_value;
+	void (*extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user);
+	const unsigned char *data;
+	size_t total_values;
+	size_t first_block;
+} BlockJobs;
+
+static size_t GetBlockStart(const BlockJobs* const jobs, const size_t block)
+{
+	return block * jobs->settings->block_size;
+}
+
+static size_t GetBlockWindowStart(const BlockJobs* const jobs, const size_t block)
+{
+	const size_t start = GetBlockStart(jobs, block);
+
+	return start - CLOWNLZSS_MIN(start, jobs->parameters->maximum_match_distance);
+}
+
+static void ParseBlockJob(void* const job_user, const size_t index)
+{
+	const BlockJobs* const jobs = (const BlockJobs*)job_user;
+	const size_t block = jobs->first_block + index;
+	const size_t start = GetBlockStart(jobs, block);
+	const size_t end = start + CLOWNLZSS_MIN(jobs->settings->block_size, jobs->total_values - start);
+	const size_t window_start = GetBlockWindowStart(jobs, block);
+	unsigned char* const buffer = &jobs->buffer[index * jobs->layout->total_size];
+	ClownLZSS_GraphEdge* const graph = (ClownLZSS_GraphEdge*)buffer;
+
+	Parameters parameters;
+	LiteralRuns literal_runs;
+	size_t run_end;
+
+	/* Like a stream, there are only filler values before the very start of the data. */
+	InitialiseParameters(&parameters, jobs->settings, window_start == 0 ? jobs->filler_value : -1, jobs->parameters->maximum_match_length, jobs->parameters->maximum_match_distance, jobs->extra_matches_callback, jobs->parameters->literal_cost, jobs->parameters->match_cost_callback, &jobs->data[window_start * jobs->parameters->bytes_per_value], jobs->parameters->bytes_per_value, end - window_start, jobs->parameters->user);
+	parameters.cost_table = jobs->parameters->cost_table;
+	parameters.cost_tail_length = jobs->parameters->cost_tail_length;
+	parameters.cost_tail_period = jobs->parameters->cost_tail_period;
+	parameters.cost_tail_step = jobs->parameters->cost_tail_step;
+	parameters.history = start - window_start;
+	parameters.run_end = &run_end;
+
+	run_end = parameters.history;
+
+	if (jobs->settings->total_literal_run_length_tiers != 0)
+	{
+		InitialiseLiteralRuns(&literal_runs, jobs->settings, jobs->literal_runs_deferred, (size_t*)&buffer[jobs->layout->literal_runs], GetLiteralRunCapacity(jobs->settings, jobs->parameters->total_values), parameters.history);
+		parameters.literal_runs = &literal_runs;
+	}
+
+	if (jobs->settings->maximum_repeat_match_length != 0)
+		parameters.repeats = (RepeatEdge*)&buffer[jobs->layout->repeats];
+
+	if (parameters.padding != 0)
+		InitialisePaddedHead(&parameters, &buffer[jobs->layout->padded_head]);
+
+	if (CanEmitLazyMatches(&parameters))
+	{
+		*(size_t*)&buffer[jobs->total_matches] = ParseLazy(&parameters, NULL, (ClownLZSS_Match*)graph, &buffer[jobs->layout->match_finder_buffer]);
+	}
+	else
+	{
+		ParseGraph(&parameters, jobs->match_finder, graph, &buffer[jobs->layout->match_finder_buffer]);
+
+		*(size_t*)&buffer[jobs->total_matches] = ProduceMatches(&parameters, graph, parameters.history, parameters.total_values);
+	}
+}
+
+static int GetBlockLayout(
+	Parameters* const parameters,
+	const ClownLZSS_Settings* const settings,
+	const int filler_value,
+	const size_t maximum_match_length,
+	const size_t maximum_match_distance,
+	const size_t literal_cost,
+	size_t (* const match_cost_callback)(size_t distance, size_t length, void *user),
+	const size_t bytes_per_value,
+	const size_t total_values,
+	const void* const user,
+	ClownLZSS_MatchFinder* const match_finder,
+	Layout* const layout,
+	size_t* const total_matches,
+	size_t* const total_slots
+)
+{
+	const size_t total_blocks = settings->block_size == 0 ? 0 : total_values / settings->block_size + (total_values % settings->block_size != 0);
+
+	Parameters padded_block;
+
+	if (total_blocks == 0)
+		return 0;
+
+	/* Every block after the first has the window before it, and the first has as many filler values instead, so they
+	   all need the same amount of memory. */
+	if (total_blocks == 1)
+	{
+		if (!InitialiseParameters(parameters, settings, filler_value, maximum_match_length, maximum_match_distance, NULL, literal_cost, match_cost_callback, NULL, bytes_per_value, total_values, user))
+			return 0;
+	}
+	else
+	{
+		if (settings->block_size > (size_t)-1 - maximum_match_distance
+		 || !InitialiseParameters(parameters, settings, -1, maximum_match_length, maximum_match_distance, NULL, literal_cost, match_cost_callback, NULL, bytes_per_value, maximum_match_distance + settings->block_size, user))
+			return 0;
+	}
+
+	/* There is a job per block, rather than per part of each block. */
+	*match_finder = ChooseMatchFinder(parameters, settings);
+	*total_slots = CLOWNLZSS_MIN(settings->run_jobs == NULL || settings->total_jobs == 0 ? 1 : settings->total_jobs, total_blocks);
+
+	/* That is apart from the copy of the filler values, which only the blocks whose windows begin at the start of the data
+	   need. With blocks that are smaller than the window, there can be several of them, the last of which covers the most. */
+	padded_block = *parameters;
+	padded_block.padding = filler_value == -1 ? 0 : maximum_match_distance;
+
+	return GetLayout(parameters, settings, *match_finder, layout)
+		&& (total_blocks == 1 || AddPaddedHeadToLayout(&padded_block, layout))
+		&& AddToLayout(layout, total_matches, sizeof(size_t))
+		&& layout->total_size <= (size_t)-1 / *total_slots;
+}
+
+size_t ClownLZSS_GetBlockWorkspaceSize(
+	const ClownLZSS_Settings* const settings,
+	const int filler_value,
+	const size_t maximum_match_length,
+	const size_t maximum_match_distance,
 	const size_t literal_cost,
 	size_t (* const match_cost_callback)(size_t distance, size_t length, void *user),
-	const unsigned char* const data,
 	const size_t bytes_per_value,
 	const size_t total_values,
-	ClownLZSS_Match** const _matches,
-	size_t* const _total_matches,
 	const void* const user
 )
 {
-	int success;
+	Parameters parameters;
+	ClownLZSS_MatchFinder match_finder;
+	Layout layout;
+	size_t total_matches, total_slots;
 
-	success = 0;
+	if (total_values == 0)
+		return 0;
+
+	if (!GetBlockLayout(&parameters, settings, filler_value, maximum_match_length, maximum_match_distance, literal_cost, match_cost_callback, bytes_per_value, total_values, user, &match_finder, &layout, &total_matches, &total_slots))
+		return (size_t)-1;
+
+	return layout.total_size * total_slots;
+}
+
+int ClownLZSS_FindOptimalMatchesInBlocks(
+	ClownLZSS_Workspace* const workspace,
+	const ClownLZSS_Settings* const settings,
+	const int filler_value,
+	const size_t maximum_match_length,
+	const size_t maximum_match_distance,
+	void (* const extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user),
+	const size_t literal_cost,
+	size_t (* const match_cost_callback)(size_t distance, size_t length, void *user),
+	const unsigned char* const data,
+	const size_t bytes_per_value,
+	const size_t total_values,
+	void (* const matches_callback)(const unsigned char *data, size_t position, const ClownLZSS_Match *matches, size_t total_matches, void *user),
+	void* const matches_callback_user,
+	const void* const user
+)
+{
+	Parameters parameters;
+	Layout layout;
+	BlockJobs jobs;
+	size_t total_slots, total_blocks, i;
 
-	/* Handle the edge-case where the data is empty. */
 	if (total_values == 0)
+		return 1;
+
+	if (!GetBlockLayout(&parameters, settings, filler_value, maximum_match_length, maximum_match_distance, literal_cost, match_cost_callback, bytes_per_value, total_values, user, &jobs.match_finder, &layout, &jobs.total_matches, &total_slots))
+		return 0;
+
+	jobs.buffer = (unsigned char*)ClownLZSS_ReserveWorkspace(workspace, layout.total_size * total_slots);
+
+	if (jobs.buffer == NULL)
+		return 0;
+
+	/* The costs do not depend on the data, so the first job's table is shared by all of them. */
+	if (settings->cost_distance_tiers != NULL && settings->total_cost_distance_tiers != 0)
 	{
-		*_matches = NULL;
-		*_total_matches = 0;
-		success = 1;
+		parameters.cost_table = BuildCostTable(&parameters, settings->total_cost_distance_tiers, (size_t*)&jobs.buffer[layout.cost_table]);
+		FindCostTail(&parameters, settings->total_cost_distance_tiers);
 	}
-	else
+
+	jobs.settings = settings;
+	jobs.parameters = &parameters;
+	jobs.literal_runs_deferred = settings->total_literal_run_length_tiers != 0 && CanDeferLiteralRuns(&parameters, settings);
+	jobs.layout = &layout;
+	jobs.filler_value = filler_value;
+	jobs.extra_matches_callback = extra_matches_callback;
+	jobs.data = data;
+	jobs.total_values = total_values;
+
+	total_blocks = total_values / settings->block_size + (total_values % settings->block_size != 0);
+
+	/* Each block is parsed on its own, so the jobs parse as many of them at once as they can,
+	   and then their matches are given to the callback in order. */
+	for (jobs.first_block = 0; jobs.first_block < total_blocks; jobs.first_block += total_slots)
 	{
-		const size_t node_meta_array_length = total_values + 1; /* +1 for the end-node */
-		const size_t string_list_buffer_length = maximum_match_distance * 2 + 0x100;
-		ClownLZSS_GraphEdge* const node_meta_array = (ClownLZSS_GraphEdge*)malloc(node_meta_array_length * sizeof(ClownLZSS_GraphEdge) + string_list_buffer_length * sizeof(size_t));
+		const size_t total_jobs = CLOWNLZSS_MIN(total_slots, total_blocks - jobs.first_block);
 
-		if (node_meta_array != NULL)
+		if (total_jobs == 1)
+			ParseBlockJob(&jobs, 0);
+		else
+			settings->run_jobs(ParseBlockJob, &jobs, total_jobs, settings->run_jobs_user);
+
+		for (i = 0; i < total_jobs; ++i)
 		{
-			size_t i;
-			ClownLZSS_Match *matches;
-			size_t total_matches;
+			const size_t window_start = GetBlockWindowStart(&jobs, jobs.first_block + i);
+			unsigned char* const buffer = &jobs.buffer[i * layout.total_size];
 
-			size_t* const prev = (size_t*)&node_meta_array[node_meta_array_length];
-			size_t* const next = &prev[maximum_match_distance];
-			const size_t DUMMY = -1;
+			matches_callback(&data[window_start * bytes_per_value], window_start, (const ClownLZSS_Match*)buffer, *(const size_t*)&buffer[jobs.total_matches], matches_callback_user);
+		}
+	}
 
-			/* Initialise the string list heads */
-			for (i = 0; i < 0x100; ++i)
-				next[maximum_match_distance + i] = DUMMY;
+	return 1;
+}
 
-			if (filler_value == -1)
-			{
-				/* Initialise the string list nodes */
-				for (i = 0; i < maximum_match_distance; ++i)
-					prev[i] = DUMMY;
-			}
-			else
-			{
-				next[maximum_match_distance + filler_value] = maximum_match_distance - 1;
-				next[0] = DUMMY;
-				prev[maximum_match_distance - 1] = maximum_match_distance + filler_value;
+/************\
+* Candidates *
+\************/
 
-				/* Initialise the string list nodes */
-				for (i = 0; i < maximum_match_distance - 1; ++i)
-				{
-					next[i + 1] = i;
-					prev[i] = i + 1;
-				}
-			}
+static int InitialiseCandidateParameters(
+	Parameters* const parameters,
+	const ClownLZSS_Settings* const settings,
+	const ClownLZSS_CandidateFormat* const formats,
+	const size_t total_formats,
+	const unsigned char* const data,
+	const size_t total_values
+)
+{
+	const ClownLZSS_CandidateFormat* const first_format = &formats[0];
+	size_t maximum_match_length, maximum_match_distance, minimum_match_length, i;
 
-			/* Set costs to maximum possible value, so later comparisons work */
-			node_meta_array[0].u.cost = 0;
-			for (i = 1; i < total_values + 1; ++i)
-				node_meta_array[i].u.cost = DUMMY;
+	if (total_formats == 0)
+		return 0;
 
-			/* Search for matches, to populate the edges of the LZSS graph.
-			   Notably, while doing this, we're also using a shortest-path
-			   algorithm on the edges to find the best combination of matches
-			   to produce the smallest file. */
+	maximum_match_length = 0;
+	maximum_match_distance = 0;
+	minimum_match_length = (size_t)-1;
 
-			/* Advance through the data one step at a time */
-			for (i = 0; i < total_values; ++i)
-			{
-				size_t match_string;
+	/* One search covers every format, so it needs the largest window, the longest match, and the shortest useful match of them. */
+	for (i = 0; i < total_formats; ++i)
+	{
+		const ClownLZSS_CandidateFormat* const format = &formats[i];
+		Parameters format_parameters;
 
-				const size_t string_list_head = maximum_match_distance + data[i * bytes_per_value];
-				const size_t current_string = i % maximum_match_distance;
+		if (format->filler_value != first_format->filler_value || format->bytes_per_value != first_format->bytes_per_value
+		 || !InitialiseParameters(&format_parameters, settings, format->filler_value, format->maximum_match_length, format->maximum_match_distance, NULL, format->literal_cost, format->match_cost_callback, NULL, format->bytes_per_value, total_values, format->user))
+			return 0;
 
-				if (extra_matches_callback != NULL)
-					extra_matches_callback(data, total_values, i, node_meta_array, (void*)user);
+		maximum_match_length = CLOWNLZSS_MAX(maximum_match_length, format->maximum_match_length);
+		maximum_match_distance = CLOWNLZSS_MAX(maximum_match_distance, format->maximum_match_distance);
+		minimum_match_length = CLOWNLZSS_MIN(minimum_match_length, format_parameters.minimum_match_length);
+	}
 
-				/* `string_list_head` points to a linked-list of strings in the LZSS sliding window that match at least
-				   one byte with the current string: iterate over it and generate every possible match for this string */
-				for (match_string = next[string_list_head]; match_string != DUMMY; match_string = next[match_string])
-				{
-					size_t j;
+	if (!InitialiseParameters(parameters, settings, first_format->filler_value, maximum_match_length, maximum_match_distance, NULL, first_format->literal_cost, first_format->match_cost_callback, data, first_format->bytes_per_value, total_values, first_format->user))
+		return 0;
 
-					const size_t distance = ((maximum_match_distance + i - match_string - 1) % maximum_match_distance) + 1;
-					/* If `BYTES_PER_VALUE` is not 1, then we have to re-evaluate the first value, otherwise we can skip it */
-					const unsigned int start = bytes_per_value == 1;
-					const unsigned char *current_bytes = &data[(i + start) * bytes_per_value];
-					const unsigned char *match_bytes = current_bytes - distance * bytes_per_value;
+	parameters->minimum_match_length = minimum_match_length;
 
-					for (j = start; j < CLOWNLZSS_MIN(maximum_match_length, total_values - i); ++j)
-					{
-						size_t l;
+	return 1;
+}
 
-						if (match_bytes < data)
-						{
-							for (l = 0; l < bytes_per_value; ++l)
-							{
-								const unsigned char current_byte = *current_bytes;
-								const unsigned char match_byte = (unsigned char)filler_value;
+static int GetCandidatesLayout(const Parameters* const parameters, Layout* const layout)
+{
+	/* Only the binary trees are searched, so there is no graph, nor anything else that goes with it. */
+	const size_t match_finder_buffer_size = GetBinaryTreeBufferSize(parameters);
 
-								++current_bytes;
+	layout->total_size = 0;
 
-								if (current_byte != match_byte)
-									break;
-							}
+	return match_finder_buffer_size != 0
+		&& AddToLayout(layout, &layout->match_finder_buffer, match_finder_buffer_size)
+		&& AddPaddedHeadToLayout(parameters, layout);
+}
 
-							match_bytes += bytes_per_value;
-						}
-						else
-						{
-							for (l = 0; l < bytes_per_value; ++l)
-							{
-								const unsigned char current_byte = *current_bytes;
-								const unsigned char match_byte = *match_bytes;
+size_t ClownLZSS_GetCandidatesWorkspaceSize(
+	const ClownLZSS_Settings* const settings,
+	const ClownLZSS_CandidateFormat* const formats,
+	const size_t total_formats,
+	const size_t total_values
+)
+{
+	Parameters parameters;
+	Layout layout;
 
-								++current_bytes;
-								++match_bytes;
+	if (!InitialiseCandidateParameters(&parameters, settings, formats, total_formats, NULL, total_values))
+		return (size_t)-1;
 
-								if (current_byte != match_byte)
-									break;
-							}
-						}
+	if (total_values == 0)
+		return 0;
 
-						if (l != bytes_per_value)
-						{
-							/* No match: give up on the current run */
-							break;
-						}
-						else
-						{
-							/* Figure out how much it costs to encode the current run */
-							const size_t cost = match_cost_callback(distance, j + 1, (void*)user);
+	return GetCandidatesLayout(&parameters, &layout) ? layout.total_size : (size_t)-1;
+}
 
-							/* Figure out if the cost is lower than that of any other runs that end at the same value as this one */
-							if (cost != 0 && node_meta_array[i + j + 1].u.cost > node_meta_array[i].u.cost + cost)
-							{
-								/* Record this new best run in the graph edge assigned to the value at the end of the run */
-								node_meta_array[i + j + 1].u.cost = node_meta_array[i].u.cost + cost;
-								node_meta_array[i + j + 1].previous_node_index = i;
-								node_meta_array[i + j + 1].match_offset = i - distance;
-							}
-						}
-					}
-				}
+int ClownLZSS_FindCandidates(
+	ClownLZSS_Workspace* const workspace,
+	const ClownLZSS_Settings* const settings,
+	const ClownLZSS_CandidateFormat* const formats,
+	const size_t total_formats,
+	const unsigned char* const data,
+	const size_t total_values,
+	void (* const write_candidates)(const unsigned char *bytes, size_t total_bytes, void *user),
+	void* const write_candidates_user
+)
+{
+	Parameters parameters;
+	Layout layout;
+	FieldWriter writer;
+	size_t header[CLOWNLZSS_CANDIDATES_HEADER_FIELDS];
+	unsigned char *buffer;
+	size_t i;
 
-				/* If a literal match is more efficient than all runs assigned to this value, then use that instead */
-				if (node_meta_array[i + 1].u.cost >= node_meta_array[i].u.cost + literal_cost)
-				{
-					node_meta_array[i + 1].u.cost = node_meta_array[i].u.cost + literal_cost;
-					node_meta_array[i + 1].previous_node_index = i;
-					node_meta_array[i + 1].match_offset = i + 1;
-				}
+	if (!InitialiseCandidateParameters(&parameters, settings, formats, total_formats, data, total_values))
+		return 0;
+
+	buffer = NULL;
 
-				/* Replace the oldest string in the list with the new string, since it's about to be pushed out of the LZSS sliding window */
+	if (total_values != 0)
+	{
+		if (!GetCandidatesLayout(&parameters, &layout))
+			return 0;
 
-				/* Detach the old node in this slot */
-				if (prev[current_string] != DUMMY)
-					next[prev[current_string]] = DUMMY;
+		buffer = (unsigned char*)ClownLZSS_ReserveWorkspace(workspace, layout.total_size);
 
-				/* Replace the old node with this new one, and insert it at the start of its matching list */
-				prev[current_string] = string_list_head;
-				next[current_string] = next[string_list_head];
+		if (buffer == NULL)
+			return 0;
 
-				if (next[current_string] != DUMMY)
-					prev[next[current_string]] = current_string;
+		if (parameters.padding != 0)
+			InitialisePaddedHead(&parameters, &buffer[layout.padded_head]);
+	}
 
-				next[string_list_head] = current_string;
-			}
+	InitialiseFieldWriter(&writer, write_candidates, write_candidates_user, CLOWNLZSS_CANDIDATES_MAGIC);
 
-			/* At this point, the edges will have formed a shortest-path from the start to the end:
-			   You just have to start at the last edge, and follow it backwards all the way to the start. */
+	GetCandidatesHeader(&parameters, header);
 
-			/* Mark start/end nodes for the following loops */
-			node_meta_array[0].previous_node_index = DUMMY;
-			node_meta_array[total_values].u.next_node_index = DUMMY;
+	for (i = 0; i < CLOWNLZSS_CANDIDATES_HEADER_FIELDS; ++i)
+		PutField(&writer, header[i], CLOWNLZSS_CANDIDATE_FIELD_BYTES);
 
-			/* Reverse the direction of the edges, so we can parse the LZSS graph from start to end */
-			for (i = total_values; node_meta_array[i].previous_node_index != DUMMY; i = node_meta_array[i].previous_node_index)
-				node_meta_array[node_meta_array[i].previous_node_index].u.next_node_index = i;
+	/* The binary trees find the nearest match of every length, which is all that any of the formats needs, as long as its
+	   matches never become cheaper as their distance increases. */
+	if (total_values != 0)
+		SearchBinaryTrees(&parameters, NULL, &buffer[layout.match_finder_buffer], &writer);
 
-			/* Produce an array of LZSS matches for the caller to process. It's safe to overwrite the LZSS graph to do this. */
-			matches = (ClownLZSS_Match*)node_meta_array;
-			total_matches = 0;
+	FlushFields(&writer);
 
-			i = 0;
-			while (node_meta_array[i].u.next_node_index != DUMMY)
-			{
-				const size_t next_index = node_meta_array[i].u.next_node_index;
-				const size_t offset = node_meta_array[next_index].match_offset;
+	return 1;
+}
+
+#ifndef CLOWNLZSS_FREESTANDING
+int ClownLZSS_FindOptimalMatches(
+	const int filler_value,
+	const size_t maximum_match_length,
+	const size_t maximum_match_distance,
+	void (* const extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user),
+	const size_t literal_cost,
+	size_t (* const match_cost_callback)(size_t distance, size_t length, void *user),
+	const unsigned char* const data,
+	const size_t bytes_per_value,
+	const size_t total_values,
+	ClownLZSS_Match** const _matches,
+	size_t* const _total_matches,
+	const void* const user
+)
+{
+	ClownLZSS_Settings settings;
 
-				matches[total_matches].source = offset;
-				matches[total_matches].destination = i;
-				matches[total_matches].length = next_index - i;
+	InitialiseSettings(&settings);
 
-				++total_matches;
+	return ClownLZSS_FindOptimalMatchesWithSettings(&settings, filler_value, maximum_match_length, maximum_match_distance, extra_matches_callback, literal_cost, match_cost_callback, data, bytes_per_value, total_values, _matches, _total_matches, user);
+}
 
-				i = next_index;
-			}
+int ClownLZSS_FindOptimalMatchesWithSettings(
+	const ClownLZSS_Settings* const settings,
+	const int filler_value,
+	const size_t maximum_match_length,
+	const size_t maximum_match_distance,
+	void (* const extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user),
+	const size_t literal_cost,
+	size_t (* const match_cost_callback)(size_t distance, size_t length, void *user),
+	const unsigned char* const data,
+	const size_t bytes_per_value,
+	const size_t total_values,
+	ClownLZSS_Match** const _matches,
+	size_t* const _total_matches,
+	const void* const user
+)
+{
+	ClownLZSS_Workspace workspace;
 
-			*_matches = matches;
-			*_total_matches = total_matches;
-			success = 1;
-		}
+	ClownLZSS_InitialiseWorkspace(&workspace, NULL);
+
+	if (!ClownLZSS_FindOptimalMatchesWithWorkspace(&workspace, settings, filler_value, maximum_match_length, maximum_match_distance, extra_matches_callback, literal_cost, match_cost_callback, data, bytes_per_value, total_values, _matches, _total_matches, user))
+	{
+		ClownLZSS_DeinitialiseWorkspace(&workspace);
+		return 0;
 	}
 
-	return success;
+	/* The matches are at the very start of the workspace's buffer, which came from `malloc`, so the caller can take
+	   ownership of it and `free` it when they are done. */
+	return 1;
 }
+#endif
@@ -16,8 +16,15 @@ PERFORMANCE OF THIS SOFTWARE.
 #ifndef CLOWNLZSS_H
 #define CLOWNLZSS_H
 
+/* Freestanding builds have no `malloc`, so they can only use workspaces that are given a buffer up-front. */
+#if defined(__STDC_HOSTED__) && __STDC_HOSTED__ == 0
+#define CLOWNLZSS_FREESTANDING
+#endif
+
 #include <stddef.h>
+#ifndef CLOWNLZSS_FREESTANDING
 #include <stdlib.h>
+#endif
 
 #define CLOWNLZSS_MIN(a, b) ((a) < (b) ? (a) : (b))
 #define CLOWNLZSS_MAX(a, b) ((a) > (b) ? (a) : (b))
@@ -42,10 +49,370 @@ typedef struct ClownLZSS_Match
 
 #define CLOWNLZSS_MATCH_IS_LITERAL(match) ((match)->source == (match)->destination + 1)
 
+typedef enum ClownLZSS_Parser
+{
+	/* Finds the cheapest combination of every match that the match finder produces. */
+	CLOWNLZSS_PARSER_OPTIMAL,
+	/* Takes the best match at each position, unless the next position has a better one, like zlib does. Only the values
+	   between the matches are parsed optimally. Much faster, but the output is larger. Always uses the hash-chains, and
+	   limits them even at the highest effort. Unless there are extra matches, literal runs, repeat matches, or descriptor
+	   fields to choose between, no graph is built, and the matches are written out as they are taken. Combine with a
+	   stream to keep the memory bounded by the window. */
+	CLOWNLZSS_PARSER_LAZY
+} ClownLZSS_Parser;
+
+typedef enum ClownLZSS_MatchFinder
+{
+	/* Uses the binary tree for large windows, and the hash-chains otherwise. */
+	CLOWNLZSS_MATCH_FINDER_AUTOMATIC,
+	/* Walks a chain of every earlier string that shares a short prefix with the current one.
+	   Works with any cost function. */
+	CLOWNLZSS_MATCH_FINDER_HASH_CHAIN,
+	/* Keeps the strings that share a short prefix in a binary tree, and only visits the ones that produce a
+	   longer match than the last. Has the same requirement as the suffix array below. */
+	CLOWNLZSS_MATCH_FINDER_BINARY_TREE,
+	/* Builds a suffix array of the whole input up-front, and finds only the nearest match for each length,
+	   without comparing any bytes. The time taken depends on the maximum match length instead of on how
+	   repetitive the data is. For the output to be optimal, a match must never become cheaper as its
+	   distance increases (with a cost of 0 counting as infinitely expensive). */
+	CLOWNLZSS_MATCH_FINDER_SUFFIX_ARRAY,
+	/* Does not search the data at all, and only tries `ClownLZSS_Settings::hints`, along with the literals and everything
+	   else that the format has. Very fast, but the output can only be as good as the hints allow. Without any hints, the
+	   automatic match finder is used instead. */
+	CLOWNLZSS_MATCH_FINDER_HINTS,
+	/* Does not search the data either, and only tries `ClownLZSS_Settings::candidates`, which several formats can share.
+	   Has the same requirement as the suffix array. Used by default whenever the candidates suit the format, and, when
+	   they do not, the automatic match finder is used instead. */
+	CLOWNLZSS_MATCH_FINDER_CANDIDATES
+} ClownLZSS_MatchFinder;
+
+typedef struct ClownLZSS_Settings
+{
+	ClownLZSS_Parser parser;
+	ClownLZSS_MatchFinder match_finder;
+	/* Optional. The cost of a match usually only changes at a few distances, so these are the largest
+	   distances of each range that the match cost callback treats the same, in increasing order. When
+	   provided, the costs are put in a table up-front instead of calling the callback for every match.
+	   If the tiers turn out to be wrong, then the callback is used as normal. */
+	const size_t *cost_distance_tiers;
+	size_t total_cost_distance_tiers;
+	/* Optional. Some formats can also store values as they are in runs of varying length, with a header that grows with
+	   the run. These are the longest run that each size of header allows, in increasing order, and what each header
+	   costs. On top of that, every value in the run costs `literal_run_value_cost`. The parser relaxes these runs by
+	   itself, in constant time per position instead of one edge per length, and they appear as matches whose source is
+	   the same as their destination. Like the extra matches callback, they win ties with matches from the same position. */
+	const size_t *literal_run_length_tiers;
+	const size_t *literal_run_header_costs;
+	size_t total_literal_run_length_tiers;
+	size_t literal_run_value_cost;
+	/* Optional. Some formats can repeat the distance of the last match more cheaply than they can encode a new one. If this
+	   is not 0, then a match of up to this many values at that distance costs `repeat_match_cost`. This is a heuristic,
+	   and the parse is no longer optimal: each position only keeps the distance that the cheapest path to it leaves
+	   behind, so a path that costs more to get there, but leaves a distance that is cheaper to repeat later, is never
+	   found. Like the extra matches callback, these matches win ties with the literal runs. Before the first match, there
+	   is no distance to repeat. */
+	size_t maximum_repeat_match_length;
+	size_t repeat_match_cost;
+	/* Optional. Many formats interleave their data with fields of this many descriptor bits, which are only ever written
+	   whole, so the bits that the costs charge for them are only an estimate of the true size. If `exact_size` is true,
+	   then the parse keeps track of how full the field is at each position, and picks the matches that need the fewest
+	   bytes once every field is rounded up, which takes this many times as much memory and time. The costs must be in
+	   bits, with the data in whole bytes, so that the descriptor bits of each match and literal are what is left over
+	   after dividing its cost by 8. `trailing_descriptor_bits` are pushed after the last match, such as for an
+	   end-of-data marker, and, if `descriptor_field_written_when_full` is true, then a field is written as soon as it is
+	   full, so there is always one more after it, even if it stays empty. The extra matches callback must not add an edge
+	   more than `maximum_extra_match_length` values past its offset. Streams, the literal runs, and the repeat matches
+	   ignore `exact_size`. */
+	size_t descriptor_field_bits;
+	size_t trailing_descriptor_bits;
+	int descriptor_field_written_when_full;
+	size_t maximum_extra_match_length;
+	int exact_size;
+	/* Optional. If not NULL, then this is used instead of the extra matches callback. It is the same, except that it is
+	   also told how many values from `offset` onwards are the same as the one there, in `run_length`, so that formats
+	   that encode runs do not have to count them again at every position. */
+	void (*extra_run_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, size_t run_length, ClownLZSS_GraphEdge *node_meta_array, void *user);
+	/* Optional. If not NULL, then the optimal parser searches the hash-chains in several parts of the data at once, by
+	   calling this with `total_jobs` jobs at a time, which must all have finished by the time that it returns. They can
+	   be run in any order, and on any threads. Only the search is split up, as the graph is still relaxed one position
+	   at a time, so the matches are exactly the same either way. Without an effort limit, the hash-chains are then used
+	   by default, as every match finder produces the same matches. Streams and the lazy parser ignore this, and blocks
+	   (see below) use it to parse several blocks at once instead. */
+	void (*run_jobs)(void (*job)(void *job_user, size_t index), void *job_user, size_t total_jobs, void *user);
+	void *run_jobs_user;
+	size_t total_jobs;
+	/* Only used by `ClownLZSS_FindOptimalMatchesInBlocks`, which requires it to be non-zero. The data is split into blocks
+	   of this many values, which are parsed separately, so that `run_jobs` can parse `total_jobs` of them at once. Matches
+	   can still reach back into the blocks before, but the path is cut at the start of each block, so a match cannot
+	   cross it, and no literal run or repeated distance carries over it either. The output may be slightly larger (with
+	   Kosinski and Saxman, by less than a byte per block of 0x40000 values), but does not depend on the number of jobs. Larger blocks lose less, but need more memory per job. `exact_size` is
+	   ignored. */
+	size_t block_size;
+	/* Optional. Matches to try on top of the ones that the match finder finds, such as the ones that were decoded from a
+	   file in another format. They are in order of destination, and unlike every other match, they are in bytes instead of
+	   values, so ones that do not line up with the values are ignored. Once a hint has been reached, its distance is tried
+	   at every position until a few newer hints have replaced it, which also covers the rest of the hint itself. Every
+	   match is checked against the data, so a hint that is wrong is only shortened or ignored. Hints that are not before
+	   their destination, such as literals, are ignored, and so are the hints of streams and blocks. */
+	const ClownLZSS_Match *hints;
+	size_t total_hints;
+	/* Optional. The matches that `ClownLZSS_FindCandidates` found in the same data, so that producing it in several formats
+	   only searches it once. They are only used if they were found for the same filler value and size of value, with a
+	   window and maximum match length that are at least as large as the format's, and a minimum match length that is no
+	   larger than the shortest useful match of the format. Streams and blocks ignore these. */
+	const unsigned char *candidates;
+	size_t candidates_size;
+	/* Optional. If not NULL, then `write_checkpoint` is given a checkpoint of the parse, a piece at a time, which holds
+	   the data and the cheapest path to every position in it. If it is given back as `checkpoint` when the data is parsed
+	   again with the same format and settings, then the cheapest paths up to the first value that changed are kept, so
+	   the parse only begins the longest match before it, and the matches are the same as without the checkpoint, unless
+	   there is an effort limit. A checkpoint that does not match the format, the settings, or the start of the data is
+	   ignored. Nothing is written or kept with the lazy parser, the literal runs, the repeat matches, `exact_size`, or hints, or
+	   if there is an extra matches callback but no `maximum_extra_match_length`. Streams and blocks ignore these. */
+	const unsigned char *checkpoint;
+	size_t checkpoint_size;
+	void (*write_checkpoint)(const unsigned char *bytes, size_t total_bytes, void *user);
+	void *write_checkpoint_user;
+	/* Only used by streams, which require it to be non-zero. The most values that are parsed at once: the shortest
+	   path is settled at the last point that every path passes through, or at the horizon if there is no such point
+	   in the second half of it, which is where the output may stop being optimal. Larger horizons use more memory,
+	   but are less likely to be cut short. */
+	size_t horizon;
+	/* These trade compression for speed, with 0 meaning no limit, which is the default: */
+	/* The most earlier strings that are compared with each string. */
+	size_t maximum_chain_length;
+	/* Stop looking for longer matches once a match is at least this long. */
+	size_t nice_match_length;
+	/* Matches that are at least this long are used without parsing the values that they cover. */
+	size_t good_match_length;
+} ClownLZSS_Settings;
+
+typedef struct ClownLZSS_Allocator
+{
+	void* (*allocate)(size_t size, void *user);
+	void (*deallocate)(void *memory, void *user);
+	void *user;
+} ClownLZSS_Allocator;
+
+/* Holds all of the memory that the parser needs, so that it can be reused between calls instead of being allocated
+   each time. It grows as needed, unless it was given a fixed buffer. Treat the members as private. */
+typedef struct ClownLZSS_Workspace
+{
+	ClownLZSS_Allocator allocator;
+	void *buffer;
+	size_t size;
+} ClownLZSS_Workspace;
+
+/* What `ClownLZSS_FindCandidates` needs to know about each format, with the same meaning as the arguments of
+   `ClownLZSS_FindOptimalMatchesWithWorkspace`. */
+typedef struct ClownLZSS_CandidateFormat
+{
+	int filler_value;
+	size_t maximum_match_length;
+	size_t maximum_match_distance;
+	size_t literal_cost;
+	size_t (*match_cost_callback)(size_t distance, size_t length, void *user);
+	size_t bytes_per_value;
+	const void *user;
+} ClownLZSS_CandidateFormat;
+
+/* Parses data as it arrives, instead of needing all of it up-front, and needs only enough memory for the sliding
+   window and the horizon. Treat the members as private. */
+typedef struct ClownLZSS_Stream
+{
+	ClownLZSS_Settings settings;
+	int filler_value;
+	size_t maximum_match_length;
+	size_t maximum_match_distance;
+	void (*extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user);
+	size_t maximum_extra_match_length;
+	size_t literal_cost;
+	size_t (*match_cost_callback)(size_t distance, size_t length, void *user);
+	size_t bytes_per_value;
+	void (*matches_callback)(const unsigned char *data, size_t position, const ClownLZSS_Match *matches, size_t total_matches, void *user);
+	void *matches_callback_user;
+	const void *user;
+
+	ClownLZSS_MatchFinder match_finder;
+	ClownLZSS_GraphEdge *graph;
+	size_t *cost_table;
+	size_t cost_tail_length;
+	size_t cost_tail_period;
+	size_t cost_tail_step;
+	size_t *literal_run_buffer;
+	int literal_runs_deferred;
+	void *repeats;
+	size_t repeat_distance;
+	void *match_finder_buffer;
+	unsigned char *padded_head;
+
+	/* The sliding window, followed by the values that have yet to be parsed. */
+	unsigned char *buffer;
+	size_t capacity;
+	size_t total_buffered;
+	/* How many values at the start of the buffer have already been parsed. */
+	size_t history;
+	/* The position of the start of the buffer within the whole data. */
+	size_t position;
+} ClownLZSS_Stream;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+void ClownLZSS_InitialiseSettings(ClownLZSS_Settings *settings);
+/* Sets the effort settings from a level between 1 (fastest) and 9 (smallest, and the default). */
+void ClownLZSS_SetEffortLevel(ClownLZSS_Settings *settings, unsigned int level);
+
+/* If `allocator` is NULL, then `malloc` and `free` are used. */
+void ClownLZSS_InitialiseWorkspace(ClownLZSS_Workspace *workspace, const ClownLZSS_Allocator *allocator);
+/* The buffer must be aligned for any type, as if it came from `malloc`. It is not freed by `ClownLZSS_DeinitialiseWorkspace`. */
+void ClownLZSS_InitialiseWorkspaceWithBuffer(ClownLZSS_Workspace *workspace, void *buffer, size_t size);
+void ClownLZSS_DeinitialiseWorkspace(ClownLZSS_Workspace *workspace);
+/* Returns a buffer of at least `size` bytes, or NULL if the workspace cannot grow that large.
+   The contents of the buffer are not kept from the last time that it was used. */
+void* ClownLZSS_ReserveWorkspace(ClownLZSS_Workspace *workspace, size_t size);
+
+/* Returns exactly how many bytes of workspace `ClownLZSS_FindOptimalMatchesWithWorkspace` needs for these arguments, or
+   `(size_t)-1` if it would fail regardless. The size never shrinks as `total_values` grows, so the size for the largest
+   input is enough for all of the others. */
+size_t ClownLZSS_GetWorkspaceSize(
+	const ClownLZSS_Settings *settings,
+	int filler_value,
+	size_t maximum_match_length,
+	size_t maximum_match_distance,
+	size_t literal_cost,
+	size_t (*match_cost_callback)(size_t distance, size_t length, void *user),
+	size_t bytes_per_value,
+	size_t total_values,
+	const void *user
+);
+
+/* The matches are stored in the workspace, so they only last until it is next used. */
+int ClownLZSS_FindOptimalMatchesWithWorkspace(
+	ClownLZSS_Workspace *workspace,
+	const ClownLZSS_Settings *settings,
+	int filler_value,
+	size_t maximum_match_length,
+	size_t maximum_match_distance,
+	void (*extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user),
+	size_t literal_cost,
+	size_t (*match_cost_callback)(size_t distance, size_t length, void *user),
+	const unsigned char *data,
+	size_t bytes_per_value,
+	size_t total_values,
+	ClownLZSS_Match **matches,
+	size_t *total_matches,
+	const void *user
+);
+
+/* Returns exactly how many bytes of workspace `ClownLZSS_BeginStream` needs for these arguments, or `(size_t)-1` if it
+   would fail regardless. This does not depend on the size of the data. */
+size_t ClownLZSS_GetStreamWorkspaceSize(
+	const ClownLZSS_Settings *settings,
+	int filler_value,
+	size_t maximum_match_length,
+	size_t maximum_match_distance,
+	size_t maximum_extra_match_length,
+	size_t literal_cost,
+	size_t (*match_cost_callback)(size_t distance, size_t length, void *user),
+	size_t bytes_per_value,
+	const void *user
+);
+
+/* `maximum_extra_match_length` is the furthest past its offset that the extra matches callback can add an edge, or 0 if it
+   does not add any. The workspace is used for the whole stream, so it cannot be used for anything else until the stream
+   ends. `matches_callback` receives the matches of each part of the data as soon as they are settled: they index into
+   `data`, which holds the sliding window and the values that are being parsed, and starts at `position` in the whole
+   data. Returns 0 if the workspace is too small. */
+int ClownLZSS_BeginStream(
+	ClownLZSS_Stream *stream,
+	ClownLZSS_Workspace *workspace,
+	const ClownLZSS_Settings *settings,
+	int filler_value,
+	size_t maximum_match_length,
+	size_t maximum_match_distance,
+	void (*extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user),
+	size_t maximum_extra_match_length,
+	size_t literal_cost,
+	size_t (*match_cost_callback)(size_t distance, size_t length, void *user),
+	size_t bytes_per_value,
+	void (*matches_callback)(const unsigned char *data, size_t position, const ClownLZSS_Match *matches, size_t total_matches, void *user),
+	void *matches_callback_user,
+	const void *user
+);
+void ClownLZSS_WriteStream(ClownLZSS_Stream *stream, const unsigned char *data, size_t total_values);
+/* Parses the rest of the data. */
+void ClownLZSS_EndStream(ClownLZSS_Stream *stream);
+
+/* Returns exactly how many bytes of workspace `ClownLZSS_FindOptimalMatchesInBlocks` needs for these arguments, or
+   `(size_t)-1` if it would fail regardless. This depends on the block size and the number of jobs, but the size of the
+   data only matters while it fits in fewer blocks than there are jobs. */
+size_t ClownLZSS_GetBlockWorkspaceSize(
+	const ClownLZSS_Settings *settings,
+	int filler_value,
+	size_t maximum_match_length,
+	size_t maximum_match_distance,
+	size_t literal_cost,
+	size_t (*match_cost_callback)(size_t distance, size_t length, void *user),
+	size_t bytes_per_value,
+	size_t total_values,
+	const void *user
+);
+
+/* Parses the data in blocks of `ClownLZSS_Settings::block_size` values. `matches_callback` receives the matches of each
+   block in order, like a stream's: they index into `data`, which holds the block and the window before it, and starts at
+   `position` in the whole data. */
+int ClownLZSS_FindOptimalMatchesInBlocks(
+	ClownLZSS_Workspace *workspace,
+	const ClownLZSS_Settings *settings,
+	int filler_value,
+	size_t maximum_match_length,
+	size_t maximum_match_distance,
+	void (*extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user),
+	size_t literal_cost,
+	size_t (*match_cost_callback)(size_t distance, size_t length, void *user),
+	const unsigned char *data,
+	size_t bytes_per_value,
+	size_t total_values,
+	void (*matches_callback)(const unsigned char *data, size_t position, const ClownLZSS_Match *matches, size_t total_matches, void *user),
+	void *matches_callback_user,
+	const void *user
+);
+
+/* Returns exactly how many bytes of workspace `ClownLZSS_FindCandidates` needs for these arguments, or `(size_t)-1` if it
+   would fail regardless. */
+size_t ClownLZSS_GetCandidatesWorkspaceSize(
+	const ClownLZSS_Settings *settings,
+	const ClownLZSS_CandidateFormat *formats,
+	size_t total_formats,
+	size_t total_values
+);
+
+/* Finds the nearest match of every length at each position, once for every one of the formats, with the largest window
+   and maximum match length of them, and the shortest match that any of them can use. The formats must all have the same
+   filler value and size of value. `write_candidates` is given the candidates a piece at a time, and, once they have been
+   put back together, they can be given to the parse of each format as `ClownLZSS_Settings::candidates`. Only the effort
+   settings are used. */
+int ClownLZSS_FindCandidates(
+	ClownLZSS_Workspace *workspace,
+	const ClownLZSS_Settings *settings,
+	const ClownLZSS_CandidateFormat *formats,
+	size_t total_formats,
+	const unsigned char *data,
+	size_t total_values,
+	void (*write_candidates)(const unsigned char *bytes, size_t total_bytes, void *user),
+	void *write_candidates_user
+);
+
+#ifndef CLOWNLZSS_FREESTANDING
+/* These allocate the matches with `malloc`, so they must be freed with `free`.
+   On 64-bit CPUs, the graph uses nodes of half the usual size, as long as every position and cost fits in 32 bits: there
+   must be fewer than 0xFFFFFFFF values, and `literal_cost * (total_values + 1)` must be less than 0xFFFFFFFF, as nothing
+   costs more than the literals. It also needs no extra matches callback, literal runs, repeat matches, or `exact_size`,
+   as those need the full-size nodes. Otherwise, or beyond that size, the full-size nodes are used instead, which takes
+   about twice as much memory for the graph, but gives the same matches. This applies to every function that finds
+   matches, and the workspace size is the same either way. */
 int ClownLZSS_FindOptimalMatches(
 	int filler_value,
 	size_t maximum_match_length,
@@ -61,17 +428,84 @@ int ClownLZSS_FindOptimalMatches(
 	const void *user
 );
 
+int ClownLZSS_FindOptimalMatchesWithSettings(
+	const ClownLZSS_Settings *settings,
+	int filler_value,
+	size_t maximum_match_length,
+	size_t maximum_match_distance,
+	void (*extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user),
+	size_t literal_cost,
+	size_t (*match_cost_callback)(size_t distance, size_t length, void *user),
+	const unsigned char *data,
+	size_t bytes_per_value,
+	size_t total_values,
+	ClownLZSS_Match **matches,
+	size_t *total_matches,
+	const void *user
+);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
 
 #if defined(__cplusplus) && __cplusplus >= 201103L
+#ifndef CLOWNLZSS_FREESTANDING
 #include <memory>
+#include <thread>
+#include <vector>
+#endif
+#include <type_traits>
 
 namespace ClownLZSS
 {
+	using ExtraMatchesCallback = void (*)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user);
+	using ExtraRunMatchesCallback = void (*)(const unsigned char *data, size_t total_values, size_t offset, size_t run_length, ClownLZSS_GraphEdge *node_meta_array, void *user);
+	using MatchCostCallback = size_t (*)(size_t distance, size_t length, void *user);
+
+	class Workspace
+	{
+	private:
+		ClownLZSS_Workspace workspace;
+
+	public:
+		Workspace()
+		{
+			ClownLZSS_InitialiseWorkspace(&workspace, nullptr);
+		}
+
+		explicit Workspace(const ClownLZSS_Allocator &allocator)
+		{
+			ClownLZSS_InitialiseWorkspace(&workspace, &allocator);
+		}
+
+		Workspace(void* const buffer, const size_t size)
+		{
+			ClownLZSS_InitialiseWorkspaceWithBuffer(&workspace, buffer, size);
+		}
+
+		~Workspace()
+		{
+			ClownLZSS_DeinitialiseWorkspace(&workspace);
+		}
+
+		Workspace(const Workspace&) = delete;
+		Workspace& operator=(const Workspace&) = delete;
+
+		void* Reserve(const size_t size)
+		{
+			return ClownLZSS_ReserveWorkspace(&workspace, size);
+		}
+
+		ClownLZSS_Workspace* Get()
+		{
+			return &workspace;
+		}
+	};
+
 	namespace Internal
 	{
+	#ifndef CLOWNLZSS_FREESTANDING
 		struct MatchDeleter
 		{
 			void operator()(ClownLZSS_Match* const a)
@@ -79,10 +513,164 @@ namespace ClownLZSS
 				free(a);
 			}
 		};
+	#endif
+
+		/* `FindExtraMatches` is optional, so formats that lack it get a null callback instead. */
+		template<typename Format>
+		constexpr auto GetExtraMatchesCallback(int) -> typename std::decay<decltype(Format::FindExtraMatches)>::type
+		{
+			return Format::FindExtraMatches;
+		}
+
+		template<typename Format>
+		constexpr ExtraMatchesCallback GetExtraMatchesCallback(long)
+		{
+			return nullptr;
+		}
+
+		/* Likewise, `maximum_extra_match_length` is optional. */
+		template<typename Format>
+		constexpr auto GetMaximumExtraMatchLength(int) -> decltype(size_t(Format::maximum_extra_match_length))
+		{
+			return Format::maximum_extra_match_length;
+		}
+
+		template<typename Format>
+		constexpr size_t GetMaximumExtraMatchLength(long)
+		{
+			return 0;
+		}
+
+		/* Likewise, `FindExtraRunMatches` is optional. */
+		template<typename Format>
+		inline auto SetExtraRunMatches(ClownLZSS_Settings &settings, int) -> decltype(void(Format::FindExtraRunMatches))
+		{
+			settings.extra_run_matches_callback = Format::FindExtraRunMatches;
+		}
+
+		template<typename Format>
+		inline void SetExtraRunMatches(ClownLZSS_Settings&, long)
+		{
+
+		}
+
+		/* Likewise, `cost_distance_tiers` is optional. */
+		template<typename Format>
+		inline auto SetCostDistanceTiers(ClownLZSS_Settings &settings, int) -> decltype(void(Format::cost_distance_tiers))
+		{
+			settings.cost_distance_tiers = Format::cost_distance_tiers;
+			settings.total_cost_distance_tiers = sizeof(Format::cost_distance_tiers) / sizeof(Format::cost_distance_tiers[0]);
+		}
+
+		template<typename Format>
+		inline void SetCostDistanceTiers(ClownLZSS_Settings&, long)
+		{
+
+		}
+
+		/* Likewise, the literal runs are optional. */
+		template<typename Format>
+		inline auto SetLiteralRuns(ClownLZSS_Settings &settings, int) -> decltype(void(Format::literal_run_length_tiers))
+		{
+			static_assert(sizeof(Format::literal_run_length_tiers) / sizeof(Format::literal_run_length_tiers[0]) == sizeof(Format::literal_run_header_costs) / sizeof(Format::literal_run_header_costs[0]), "Every literal run length tier needs a header cost.");
+
+			settings.literal_run_length_tiers = Format::literal_run_length_tiers;
+			settings.literal_run_header_costs = Format::literal_run_header_costs;
+			settings.total_literal_run_length_tiers = sizeof(Format::literal_run_length_tiers) / sizeof(Format::literal_run_length_tiers[0]);
+			settings.literal_run_value_cost = Format::literal_run_value_cost;
+		}
+
+		template<typename Format>
+		inline void SetLiteralRuns(ClownLZSS_Settings&, long)
+		{
+
+		}
+
+		/* Likewise, the repeat matches are optional. */
+		template<typename Format>
+		inline auto SetRepeatMatches(ClownLZSS_Settings &settings, int) -> decltype(void(Format::maximum_repeat_match_length))
+		{
+			settings.maximum_repeat_match_length = Format::maximum_repeat_match_length;
+			settings.repeat_match_cost = Format::repeat_match_cost;
+		}
+
+		template<typename Format>
+		inline void SetRepeatMatches(ClownLZSS_Settings&, long)
+		{
+
+		}
+
+		/* Likewise, the descriptor fields are optional. */
+		template<typename Format>
+		inline auto SetDescriptorFields(ClownLZSS_Settings &settings, int) -> decltype(void(Format::descriptor_field_bits))
+		{
+			settings.descriptor_field_bits = Format::descriptor_field_bits;
+			settings.trailing_descriptor_bits = Format::trailing_descriptor_bits;
+			settings.descriptor_field_written_when_full = Format::descriptor_field_written_when_full;
+		}
+
+		template<typename Format>
+		inline void SetDescriptorFields(ClownLZSS_Settings&, long)
+		{
+
+		}
+
+		template<typename Format>
+		inline ClownLZSS_Settings GetFormatSettings(ClownLZSS_Settings settings)
+		{
+			static_assert(Format::filler_value >= -1 && Format::filler_value <= 0xFF, "The filler value must be a byte, or -1 for none.");
+			static_assert(Format::maximum_match_length != 0, "The maximum match length cannot be 0.");
+			static_assert(Format::maximum_match_distance != 0 && Format::maximum_match_distance <= 0xFFFFFFFF, "The maximum match distance must be between 1 and 0xFFFFFFFF.");
+			static_assert(Format::bytes_per_value != 0, "A value must be at least one byte.");
+
+			if (settings.cost_distance_tiers == nullptr)
+				SetCostDistanceTiers<Format>(settings, 0);
+
+			if (settings.literal_run_length_tiers == nullptr)
+				SetLiteralRuns<Format>(settings, 0);
+
+			if (settings.maximum_repeat_match_length == 0)
+				SetRepeatMatches<Format>(settings, 0);
+
+			if (settings.descriptor_field_bits == 0)
+				SetDescriptorFields<Format>(settings, 0);
+
+			if (settings.maximum_extra_match_length == 0)
+				settings.maximum_extra_match_length = GetMaximumExtraMatchLength<Format>(0);
+
+			if (settings.extra_run_matches_callback == nullptr)
+				SetExtraRunMatches<Format>(settings, 0);
+
+			return settings;
+		}
+
+		inline ClownLZSS_Settings GetDefaultSettings()
+		{
+			ClownLZSS_Settings settings;
+			ClownLZSS_InitialiseSettings(&settings);
+			return settings;
+		}
 	}
 
+	#ifndef CLOWNLZSS_FREESTANDING
 	using Matches = std::unique_ptr<ClownLZSS_Match[], Internal::MatchDeleter>;
 
+	/* Can be used as `ClownLZSS_Settings::run_jobs`, to run each job on a thread of its own. */
+	inline void RunJobsOnThreads(void (* const job)(void *job_user, size_t index), void* const job_user, const size_t total_jobs, void*)
+	{
+		std::vector<std::thread> threads;
+
+		threads.reserve(total_jobs - 1);
+
+		for (size_t i = 1; i < total_jobs; ++i)
+			threads.emplace_back(job, job_user, i);
+
+		job(job_user, 0);
+
+		for (auto &thread : threads)
+			thread.join();
+	}
+
 	inline bool FindOptimalMatches(
 		int filler_value,
 		size_t maximum_match_length,
@@ -105,6 +693,181 @@ namespace ClownLZSS
 
 		return success;
 	}
+
+	inline bool FindOptimalMatches(
+		const ClownLZSS_Settings &settings,
+		int filler_value,
+		size_t maximum_match_length,
+		size_t maximum_match_distance,
+		void (*extra_matches_callback)(const unsigned char *data, size_t total_values, size_t offset, ClownLZSS_GraphEdge *node_meta_array, void *user),
+		size_t literal_cost,
+		size_t (*match_cost_callback)(size_t distance, size_t length, void *user),
+		const unsigned char *data,
+		size_t bytes_per_value,
+		size_t total_values,
+		Matches *matches,
+		size_t *total_matches,
+		const void *user
+	)
+	{
+		ClownLZSS_Match *matches_pointer;
+		const bool success = ClownLZSS_FindOptimalMatchesWithSettings(&settings, filler_value, maximum_match_length, maximum_match_distance, extra_matches_callback, literal_cost, match_cost_callback, data, bytes_per_value, total_values, &matches_pointer, total_matches, user);
+
+		*matches = Matches(matches_pointer);
+
+		return success;
+	}
+	#endif
+
+	/* These take the format's parameters from a traits type instead of from arguments, so that they are checked at
+	   compile-time and each format only has to describe itself in one place. They are only a front-end: the parse is
+	   still done by the C functions above, with the format's callbacks called through function pointers, so nothing is
+	   specialised for the format. The match costs are tabulated up-front instead (see `cost_distance_tiers`), which
+	   leaves too few calls for inlining them to make a difference. `Format` must have these members:
+	     static constexpr int filler_value; (-1 for no filler)
+	     static constexpr std::size_t maximum_match_length;
+	     static constexpr std::size_t maximum_match_distance;
+	     static constexpr std::size_t bytes_per_value;
+	     static constexpr std::size_t literal_cost;
+	     static constexpr MatchCostCallback GetMatchCost;
+	   It may also have these:
+	     static constexpr ExtraMatchesCallback FindExtraMatches;
+	     static constexpr ExtraRunMatchesCallback FindExtraRunMatches; (see `ClownLZSS_Settings::extra_run_matches_callback`)
+	     static constexpr std::size_t maximum_extra_match_length; (see `ClownLZSS_BeginStream`)
+	     static constexpr std::size_t cost_distance_tiers[]; (see `ClownLZSS_Settings::cost_distance_tiers`)
+	     static constexpr std::size_t literal_run_length_tiers[]; (see `ClownLZSS_Settings::literal_run_length_tiers`)
+	     static constexpr std::size_t literal_run_header_costs[];
+	     static constexpr std::size_t literal_run_value_cost;
+	     static constexpr std::size_t maximum_repeat_match_length; (see `ClownLZSS_Settings::maximum_repeat_match_length`)
+	     static constexpr std::size_t repeat_match_cost;
+	     static constexpr std::size_t descriptor_field_bits; (see `ClownLZSS_Settings::descriptor_field_bits`)
+	     static constexpr std::size_t trailing_descriptor_bits;
+	     static constexpr bool descriptor_field_written_when_full; */
+	template<typename Format>
+	inline bool FindOptimalMatches(Workspace &workspace, const ClownLZSS_Settings &settings, const unsigned char* const data, const size_t total_values, ClownLZSS_Match** const matches, size_t* const total_matches, const void* const user = nullptr)
+	{
+		const ClownLZSS_Settings format_settings = Internal::GetFormatSettings<Format>(settings);
+
+		return ClownLZSS_FindOptimalMatchesWithWorkspace(workspace.Get(), &format_settings, Format::filler_value, Format::maximum_match_length, Format::maximum_match_distance, Internal::GetExtraMatchesCallback<Format>(0), Format::literal_cost, Format::GetMatchCost, data, Format::bytes_per_value, total_values, matches, total_matches, user);
+	}
+
+	template<typename Format>
+	inline bool FindOptimalMatches(Workspace &workspace, const unsigned char* const data, const size_t total_values, ClownLZSS_Match** const matches, size_t* const total_matches, const void* const user = nullptr)
+	{
+		return FindOptimalMatches<Format>(workspace, Internal::GetDefaultSettings(), data, total_values, matches, total_matches, user);
+	}
+
+	/* Calls `callback(data, position, matches, total_matches)` with the matches for each part of the data in turn. If the
+	   settings have a horizon, then the data is streamed, and `data` is the sliding window that starts at `position`.
+	   Otherwise, if they have a block size, then `data` is each block and the window before it. Otherwise, it is called
+	   once, with all of the data. */
+	template<typename Format, typename Callback>
+	inline bool ParseOptimalMatches(Workspace &workspace, const ClownLZSS_Settings &settings, const unsigned char* const data, const size_t total_values, Callback &&callback, const void* const user = nullptr)
+	{
+		using CallbackType = typename std::remove_reference<Callback>::type;
+
+		const ClownLZSS_Settings format_settings = Internal::GetFormatSettings<Format>(settings);
+
+		const auto matches_callback = [](const unsigned char* const window, const size_t position, const ClownLZSS_Match* const matches, const size_t total_matches, void* const callback_pointer)
+		{
+			(*static_cast<CallbackType*>(callback_pointer))(window, position, matches, total_matches);
+		};
+
+		if (format_settings.horizon == 0 && format_settings.block_size != 0)
+		{
+			if (!ClownLZSS_FindOptimalMatchesInBlocks(workspace.Get(), &format_settings, Format::filler_value, Format::maximum_match_length, Format::maximum_match_distance, Internal::GetExtraMatchesCallback<Format>(0), Format::literal_cost, Format::GetMatchCost, data, Format::bytes_per_value, total_values, matches_callback, const_cast<void*>(static_cast<const void*>(&callback)), user))
+				return false;
+		}
+		else if (format_settings.horizon == 0)
+		{
+			ClownLZSS_Match *matches;
+			size_t total_matches;
+
+			if (!ClownLZSS_FindOptimalMatchesWithWorkspace(workspace.Get(), &format_settings, Format::filler_value, Format::maximum_match_length, Format::maximum_match_distance, Internal::GetExtraMatchesCallback<Format>(0), Format::literal_cost, Format::GetMatchCost, data, Format::bytes_per_value, total_values, &matches, &total_matches, user))
+				return false;
+
+			callback(data, static_cast<size_t>(0), static_cast<const ClownLZSS_Match*>(matches), total_matches);
+		}
+		else
+		{
+			ClownLZSS_Stream stream;
+
+			if (!ClownLZSS_BeginStream(&stream, workspace.Get(), &format_settings, Format::filler_value, Format::maximum_match_length, Format::maximum_match_distance, Internal::GetExtraMatchesCallback<Format>(0), Internal::GetMaximumExtraMatchLength<Format>(0), Format::literal_cost, Format::GetMatchCost, Format::bytes_per_value, matches_callback, const_cast<void*>(static_cast<const void*>(&callback)), user))
+				return false;
+
+			ClownLZSS_WriteStream(&stream, data, total_values);
+			ClownLZSS_EndStream(&stream);
+		}
+
+		return true;
+	}
+
+	/* Describes `Format` to `ClownLZSS_FindCandidates`. Each format has a function that does this, such as `GetKosinskiCandidateFormat`. */
+	template<typename Format>
+	inline ClownLZSS_CandidateFormat GetCandidateFormat(const void* const user = nullptr)
+	{
+		ClownLZSS_CandidateFormat format;
+
+		format.filler_value = Format::filler_value;
+		format.maximum_match_length = Format::maximum_match_length;
+		format.maximum_match_distance = Format::maximum_match_distance;
+		format.literal_cost = Format::literal_cost;
+		format.match_cost_callback = Format::GetMatchCost;
+		format.bytes_per_value = Format::bytes_per_value;
+		format.user = user;
+
+		return format;
+	}
+
+	template<typename Format>
+	inline size_t GetWorkspaceSize(const ClownLZSS_Settings &settings, const size_t total_values, const void* const user = nullptr)
+	{
+		const ClownLZSS_Settings format_settings = Internal::GetFormatSettings<Format>(settings);
+
+		/* Streams need the same amount regardless of the size of the data. */
+		if (format_settings.horizon != 0)
+			return ClownLZSS_GetStreamWorkspaceSize(&format_settings, Format::filler_value, Format::maximum_match_length, Format::maximum_match_distance, Internal::GetMaximumExtraMatchLength<Format>(0), Format::literal_cost, Format::GetMatchCost, Format::bytes_per_value, user);
+		else if (format_settings.block_size != 0)
+			return ClownLZSS_GetBlockWorkspaceSize(&format_settings, Format::filler_value, Format::maximum_match_length, Format::maximum_match_distance, Format::literal_cost, Format::GetMatchCost, Format::bytes_per_value, total_values, user);
+
+		return ClownLZSS_GetWorkspaceSize(&format_settings, Format::filler_value, Format::maximum_match_length, Format::maximum_match_distance, Format::literal_cost, Format::GetMatchCost, Format::bytes_per_value, total_values, user);
+	}
+
+	template<typename Format>
+	inline size_t GetWorkspaceSize(const size_t total_values, const void* const user = nullptr)
+	{
+		return GetWorkspaceSize<Format>(Internal::GetDefaultSettings(), total_values, user);
+	}
+
+	#ifndef CLOWNLZSS_FREESTANDING
+	template<typename Format>
+	inline bool FindOptimalMatches(const ClownLZSS_Settings &settings, const unsigned char* const data, const size_t total_values, Matches* const matches, size_t* const total_matches, const void* const user = nullptr)
+	{
+		const ClownLZSS_Settings format_settings = Internal::GetFormatSettings<Format>(settings);
+
+		return FindOptimalMatches(format_settings, Format::filler_value, Format::maximum_match_length, Format::maximum_match_distance, Internal::GetExtraMatchesCallback<Format>(0), Format::literal_cost, Format::GetMatchCost, data, Format::bytes_per_value, total_values, matches, total_matches, user);
+	}
+
+	template<typename Format>
+	inline bool FindOptimalMatches(const unsigned char* const data, const size_t total_values, Matches* const matches, size_t* const total_matches, const void* const user = nullptr)
+	{
+		return FindOptimalMatches<Format>(Internal::GetDefaultSettings(), data, total_values, matches, total_matches, user);
+	}
+
+	/* Replaces the contents of `candidates` with the ones that `ClownLZSS_FindCandidates` found. */
+	inline bool FindCandidates(Workspace &workspace, const ClownLZSS_Settings &settings, const ClownLZSS_CandidateFormat* const formats, const size_t total_formats, const unsigned char* const data, const size_t total_values, std::vector<unsigned char> &candidates)
+	{
+		const auto write_candidates = [](const unsigned char* const bytes, const size_t total_bytes, void* const user)
+		{
+			auto &candidates = *static_cast<std::vector<unsigned char>*>(user);
+			candidates.insert(candidates.end(), bytes, bytes + total_bytes);
+		};
+
+		candidates.clear();
+
+		return ClownLZSS_FindCandidates(workspace.Get(), &settings, formats, total_formats, data, total_values, write_candidates, &candidates);
+	}
+	#endif
 }
 #endif
 
@@ -17,6 +17,7 @@ PERFORMANCE OF THIS SOFTWARE.
 #define CLOWNLZSS_COMPRESSORS_COMMON_H
 
 #include "../common.h"
+#include "clownlzss.h"
 
 #include <iterator>
 #if __STDC_HOSTED__
@@ -62,7 +63,7 @@ namespace ClownLZSS
 	namespace Internal
 	{
 		template<typename T>
-		bool ModuledCompressionWrapper(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output, bool (* const compression_function)(const unsigned char *data, std::size_t data_size, CompressorOutput<T> &output), const std::size_t module_size, const std::size_t module_alignment)
+		bool ModuledCompressionWrapper(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output, bool (* const compression_function)(const unsigned char *data, std::size_t data_size, CompressorOutput<T> &output, Workspace &workspace, const ClownLZSS_Settings &settings), const std::size_t module_size, const std::size_t module_alignment, Workspace &workspace, const ClownLZSS_Settings &settings)
 		{
 			const unsigned int header = (data_size % module_size) | ((data_size / module_size) << 12);
 
@@ -77,7 +78,8 @@ namespace ClownLZSS
 
 				const auto start_position = output.Tell();
 
-				if (!compression_function(data + i, module_size < data_size - i ? module_size : data_size - i, output))
+				// Every module reuses the same workspace, so that memory is only allocated once.
+				if (!compression_function(data + i, module_size < data_size - i ? module_size : data_size - i, output, workspace, settings))
 					return false;
 
 				compressed_size = output.Distance(start_position);
@@ -36,42 +36,57 @@ namespace ClownLZSS
 				return 1 + 16;	// Descriptor bit, offset/length bytes.
 			}
 
+			struct Format
+			{
+				static constexpr int filler_value = -1;
+				static constexpr std::size_t maximum_match_length = 0x100;
+				static constexpr std::size_t maximum_match_distance = 0x100;
+				static constexpr std::size_t bytes_per_value = 2;
+				static constexpr std::size_t literal_cost = 1 + 16;
+				static constexpr MatchCostCallback GetMatchCost = Comper::GetMatchCost;
+				static constexpr std::size_t cost_distance_tiers[] = {0x100};
+				static constexpr std::size_t descriptor_field_bits = 16;
+				static constexpr std::size_t trailing_descriptor_bits = 1;
+				static constexpr bool descriptor_field_written_when_full = false;
+			};
+
 			template<typename T>
-			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output)
+			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output, Workspace &workspace, const ClownLZSS_Settings &settings)
 			{
-				constexpr unsigned int bytes_per_value = 2;
+				constexpr std::size_t bytes_per_value = Format::bytes_per_value;
 
 				// Cannot compress data that is an odd number of bytes long.
 				if (data_size % bytes_per_value != 0)
 					return false;
 
-				// Produce a series of LZSS compression matches.
-				ClownLZSS::Matches matches;
-				std::size_t total_matches;
-				if (!ClownLZSS::FindOptimalMatches(-1, 0x100, 0x100, nullptr, 1 + 16, GetMatchCost, data, bytes_per_value, data_size / bytes_per_value, &matches, &total_matches, nullptr))
-					return false;
-
 				DescriptorFieldWriter<decltype(output)> descriptor_bits(output);
 
 				// Produce Comper-formatted data.
-				for (ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
+				const auto write_matches = [&](const unsigned char* const window, std::size_t, const ClownLZSS_Match* const matches, const std::size_t total_matches)
 				{
-					if (CLOWNLZSS_MATCH_IS_LITERAL(match))
+					for (const ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
 					{
-						descriptor_bits.Push(0);
-						output.Write(data[match->destination * 2 + 0]);
-						output.Write(data[match->destination * 2 + 1]);
+						if (CLOWNLZSS_MATCH_IS_LITERAL(match))
+						{
+							descriptor_bits.Push(0);
+							output.Write(window[match->destination * 2 + 0]);
+							output.Write(window[match->destination * 2 + 1]);
+						}
+						else
+						{
+							const std::size_t distance = match->destination - match->source;
+							const std::size_t length = match->length;
+
+							descriptor_bits.Push(1);
+							output.Write(-distance & 0xFF);
+							output.Write(length - 1);
+						}
 					}
-					else
-					{
-						const std::size_t distance = match->destination - match->source;
-						const std::size_t length = match->length;
+				};
 
-						descriptor_bits.Push(1);
-						output.Write(-distance & 0xFF);
-						output.Write(length - 1);
-					}
-				}
+				// Produce a series of LZSS compression matches.
+				if (!ClownLZSS::ParseOptimalMatches<Format>(workspace, settings, data, data_size / bytes_per_value, write_matches))
+					return false;
 
 				// Add the terminator match.
 				descriptor_bits.Push(1);
@@ -84,21 +99,40 @@ namespace ClownLZSS
 	}
 
 	template<typename T>
-	bool ComperCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	bool ComperCompress(const unsigned char* const data, const std::size_t data_size, T &&output, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return Comper::Compress(data, data_size, output_wrapped);
+		return Comper::Compress(data, data_size, output_wrapped, workspace, settings);
 	}
 
 	template<typename T>
-	bool ModuledComperCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	bool ComperCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	{
+		Workspace workspace;
+		return ComperCompress(data, data_size, std::forward<T>(output), workspace);
+	}
+
+	template<typename T>
+	bool ModuledComperCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return ModuledCompressionWrapper(data, data_size, output_wrapped, Comper::Compress, module_size, 2);
+		return ModuledCompressionWrapper(data, data_size, output_wrapped, Comper::Compress, module_size, 2, workspace, settings);
+	}
+
+	template<typename T>
+	bool ModuledComperCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	{
+		Workspace workspace;
+		return ModuledComperCompress(data, data_size, std::forward<T>(output), module_size, workspace);
+	}
+
+	inline ClownLZSS_CandidateFormat GetComperCandidateFormat()
+	{
+		return GetCandidateFormat<Internal::Comper::Format>();
 	}
 }
 
@@ -18,7 +18,6 @@ PERFORMANCE OF THIS SOFTWARE.
 
 #include <algorithm>
 #include <bit>
-#include <cstdlib>
 #include <optional>
 #include <utility>
 
@@ -36,7 +35,7 @@ namespace ClownLZSS
 			using BitFieldWriter = BitField::Writer<1, BitField::WriteWhen::BeforePush, BitField::PushWhere::Low, BitField::Endian::Big, T>;
 
 			template<typename T>
-			inline bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output)
+			inline bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output, Workspace &workspace, const ClownLZSS_Settings&)
 			{
 				if (data_size == 0)
 					return true;
@@ -63,11 +62,11 @@ namespace ClownLZSS
 					unsigned int lowest;
 				};
 
-				const auto FindSpecialValues = [&ReadWord, &GetTileIndex](const unsigned char* const data, const std::size_t data_size) -> std::optional<SpecialValues>
+				const auto FindSpecialValues = [&ReadWord, &GetTileIndex, &workspace](const unsigned char* const data, const std::size_t data_size) -> std::optional<SpecialValues>
 				{
 					// Copy the input buffer.
 					const std::size_t total_values = data_size / bytes_per_value;
-					unsigned short* const sort_buffer = static_cast<unsigned short*>(std::malloc(total_values * sizeof(unsigned short)));
+					unsigned short* const sort_buffer = static_cast<unsigned short*>(workspace.Reserve(total_values * sizeof(unsigned short)));
 
 					if (sort_buffer == nullptr)
 						return std::nullopt;
@@ -123,8 +122,6 @@ namespace ClownLZSS
 						}
 					}
 
-					std::free(sort_buffer);
-
 					return SpecialValues{longest_run_value, lowest_value};
 				};
 
@@ -344,14 +341,14 @@ namespace ClownLZSS
 	}
 
 	template<typename T>
-	bool EnigmaCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	bool EnigmaCompress(const unsigned char* const data, const std::size_t data_size, T &&output, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
 
 		const auto start = output_wrapped.Tell();
-		const bool success = Enigma::Compress(data, data_size, output_wrapped);
+		const bool success = Enigma::Compress(data, data_size, output_wrapped, workspace, settings);
 
 		if (output_wrapped.Distance(start) % 2 != 0)
 			output_wrapped.Write(0);
@@ -360,12 +357,26 @@ namespace ClownLZSS
 	}
 
 	template<typename T>
-	bool ModuledEnigmaCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	bool EnigmaCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	{
+		Workspace workspace;
+		return EnigmaCompress(data, data_size, std::forward<T>(output), workspace);
+	}
+
+	template<typename T>
+	bool ModuledEnigmaCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return ModuledCompressionWrapper(data, data_size, output_wrapped, Enigma::Compress, module_size, 2);
+		return ModuledCompressionWrapper(data, data_size, output_wrapped, Enigma::Compress, module_size, 2, workspace, settings);
+	}
+
+	template<typename T>
+	bool ModuledEnigmaCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	{
+		Workspace workspace;
+		return ModuledEnigmaCompress(data, data_size, std::forward<T>(output), module_size, workspace);
 	}
 }
 
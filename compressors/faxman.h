@@ -42,44 +42,47 @@ namespace ClownLZSS
 					return 0;
 			}
 
-			inline void FindExtraMatches(const unsigned char* const data, const std::size_t data_size, const std::size_t offset, ClownLZSS_GraphEdge* const node_meta_array, [[maybe_unused]] void* const user)
+			inline void FindExtraMatches(const unsigned char* const data, [[maybe_unused]] const std::size_t data_size, const std::size_t offset, const std::size_t run_length, ClownLZSS_GraphEdge* const node_meta_array, [[maybe_unused]] void* const user)
 			{
-				if (offset < 0x800)
+				if (offset < 0x800 && data[offset] == 0)
 				{
 					std::size_t k;
 
-					const std::size_t max_read_ahead = std::min<std::size_t>(0x1F + 3, data_size - offset);
+					const std::size_t max_read_ahead = std::min<std::size_t>(0x1F + 3, run_length);
 
 					for (k = 0; k < max_read_ahead; ++k)
 					{
-						if (data[offset + k] == 0)
-						{
-							const unsigned int cost = (k + 1 >= 3) ? 2 + 16 : 0;
+						const unsigned int cost = (k + 1 >= 3) ? 2 + 16 : 0;
 
-							if (cost != 0 && node_meta_array[offset + k + 1].u.cost > node_meta_array[offset].u.cost + cost)
-							{
-								node_meta_array[offset + k + 1].u.cost = node_meta_array[offset].u.cost + cost;
-								node_meta_array[offset + k + 1].previous_node_index = offset;
-								node_meta_array[offset + k + 1].match_offset = offset;
-							}
-						}
-						else
+						if (cost != 0 && node_meta_array[offset + k + 1].u.cost > node_meta_array[offset].u.cost + cost)
 						{
-							break;
+							node_meta_array[offset + k + 1].u.cost = node_meta_array[offset].u.cost + cost;
+							node_meta_array[offset + k + 1].previous_node_index = offset;
+							node_meta_array[offset + k + 1].match_offset = offset;
 						}
 					}
 				}
 			}
 
-			template<typename T>
-			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output)
+			struct Format
 			{
-				// Produce a series of LZSS compression matches.
-				ClownLZSS::Matches matches;
-				std::size_t total_matches;
-				if (!ClownLZSS::FindOptimalMatches(-1, 0x1F + 3, 0x800, FindExtraMatches, 1 + 8, GetMatchCost, data, 1, data_size, &matches, &total_matches, nullptr))
-					return false;
+				static constexpr int filler_value = -1;
+				static constexpr std::size_t maximum_match_length = 0x1F + 3;
+				static constexpr std::size_t maximum_match_distance = 0x800;
+				static constexpr std::size_t bytes_per_value = 1;
+				static constexpr std::size_t literal_cost = 1 + 8;
+				static constexpr MatchCostCallback GetMatchCost = Faxman::GetMatchCost;
+				static constexpr std::size_t cost_distance_tiers[] = {0x100, 0x800};
+				static constexpr ExtraRunMatchesCallback FindExtraRunMatches = Faxman::FindExtraMatches;
+				static constexpr std::size_t maximum_extra_match_length = 0x1F + 3;
+				static constexpr std::size_t descriptor_field_bits = 8;
+				static constexpr std::size_t trailing_descriptor_bits = 0;
+				static constexpr bool descriptor_field_written_when_full = false;
+			};
 
+			template<typename T>
+			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output, Workspace &workspace, const ClownLZSS_Settings &settings)
+			{
 				// Track the location of the header...
 				const auto header_position = output.Tell();
 
@@ -96,35 +99,42 @@ namespace ClownLZSS
 				};
 
 				// Produce Faxman-formatted data.
-				for (ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
+				const auto write_matches = [&](const unsigned char* const window, std::size_t, const ClownLZSS_Match* const matches, const std::size_t total_matches)
 				{
-					if (CLOWNLZSS_MATCH_IS_LITERAL(match))
+					for (const ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
 					{
-						PushDescriptorBit(1);
-						output.Write(data[match->destination]);
-					}
-					else
-					{
-						const std::size_t distance = match->destination == match->source ? 0x800 : match->destination - match->source;
-						const std::size_t length = match->length;
-
-						if (length >= 2 && length <= 5 && distance <= 0x100)
+						if (CLOWNLZSS_MATCH_IS_LITERAL(match))
 						{
-							PushDescriptorBit(0);
-							PushDescriptorBit(0);
-							output.Write(-distance & 0xFF);
-							PushDescriptorBit(!!((length - 2) & 2));
-							PushDescriptorBit(!!((length - 2) & 1));
+							PushDescriptorBit(1);
+							output.Write(window[match->destination]);
 						}
-						else //if (length >= 3)
+						else
 						{
-							PushDescriptorBit(0);
-							PushDescriptorBit(1);
-							output.Write((distance - 1) & 0xFF);
-							output.Write((((distance - 1) & 0x700) >> 3) | (length - 3));
+							const std::size_t distance = match->destination == match->source ? 0x800 : match->destination - match->source;
+							const std::size_t length = match->length;
+
+							if (length >= 2 && length <= 5 && distance <= 0x100)
+							{
+								PushDescriptorBit(0);
+								PushDescriptorBit(0);
+								output.Write(-distance & 0xFF);
+								PushDescriptorBit(!!((length - 2) & 2));
+								PushDescriptorBit(!!((length - 2) & 1));
+							}
+							else //if (length >= 3)
+							{
+								PushDescriptorBit(0);
+								PushDescriptorBit(1);
+								output.Write((distance - 1) & 0xFF);
+								output.Write((((distance - 1) & 0x700) >> 3) | (length - 3));
+							}
 						}
 					}
-				}
+				};
+
+				// Produce a series of LZSS compression matches.
+				if (!ClownLZSS::ParseOptimalMatches<Format>(workspace, settings, data, data_size, write_matches))
+					return false;
 
 				// Grab the current position for later.
 				const auto end_position = output.Tell();
@@ -144,21 +154,40 @@ namespace ClownLZSS
 	}
 
 	template<typename T>
-	bool FaxmanCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	bool FaxmanCompress(const unsigned char* const data, const std::size_t data_size, T &&output, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return Faxman::Compress(data, data_size, output_wrapped);
+		return Faxman::Compress(data, data_size, output_wrapped, workspace, settings);
 	}
 
 	template<typename T>
-	bool ModuledFaxmanCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	bool FaxmanCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	{
+		Workspace workspace;
+		return FaxmanCompress(data, data_size, std::forward<T>(output), workspace);
+	}
+
+	template<typename T>
+	bool ModuledFaxmanCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return ModuledCompressionWrapper(data, data_size, output_wrapped, Faxman::Compress, module_size, 2);
+		return ModuledCompressionWrapper(data, data_size, output_wrapped, Faxman::Compress, module_size, 2, workspace, settings);
+	}
+
+	template<typename T>
+	bool ModuledFaxmanCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	{
+		Workspace workspace;
+		return ModuledFaxmanCompress(data, data_size, std::forward<T>(output), module_size, workspace);
+	}
+
+	inline ClownLZSS_CandidateFormat GetFaxmanCandidateFormat()
+	{
+		return GetCandidateFormat<Internal::Faxman::Format>();
 	}
 }
 
@@ -43,55 +43,70 @@ namespace ClownLZSS
 					return 0;          // In the event a match cannot be compressed.
 			}
 
-			template<typename T>
-			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output)
+			struct Format
 			{
-				// Produce a series of LZSS compression matches.
-				ClownLZSS::Matches matches;
-				std::size_t total_matches;
-				if (!ClownLZSS::FindOptimalMatches(-1, 0x100 + 8, 0x2000, nullptr, 1 + 8, GetMatchCost, data, 1, data_size, &matches, &total_matches, nullptr))
-					return false;
+				static constexpr int filler_value = -1;
+				static constexpr std::size_t maximum_match_length = 0x100 + 8;
+				static constexpr std::size_t maximum_match_distance = 0x2000;
+				static constexpr std::size_t bytes_per_value = 1;
+				static constexpr std::size_t literal_cost = 1 + 8;
+				static constexpr MatchCostCallback GetMatchCost = KosinskiPlus::GetMatchCost;
+				static constexpr std::size_t cost_distance_tiers[] = {0x100, 0x2000};
+				static constexpr std::size_t descriptor_field_bits = 8;
+				static constexpr std::size_t trailing_descriptor_bits = 2;
+				static constexpr bool descriptor_field_written_when_full = false;
+			};
 
+			template<typename T>
+			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output, Workspace &workspace, const ClownLZSS_Settings &settings)
+			{
 				DescriptorFieldWriter<decltype(output)> descriptor_bits(output);
 
 				// Produce Kosinski+-formatted data.
-				for (ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
+				const auto write_matches = [&](const unsigned char* const window, std::size_t, const ClownLZSS_Match* const matches, const std::size_t total_matches)
 				{
-					if (CLOWNLZSS_MATCH_IS_LITERAL(match))
-					{
-						descriptor_bits.Push(1);
-						output.Write(data[match->destination]);
-					}
-					else
+					for (const ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
 					{
-						const std::size_t distance = match->destination - match->source;
-						const std::size_t length = match->length;
-
-						if (length >= 2 && length <= 5 && distance <= 0x100)
+						if (CLOWNLZSS_MATCH_IS_LITERAL(match))
 						{
-							descriptor_bits.Push(0);
-							descriptor_bits.Push(0);
-							output.Write(-distance & 0xFF);
-							descriptor_bits.Push(!!((length - 2) & 2));
-							descriptor_bits.Push(!!((length - 2) & 1));
-						}
-						else if (length >= 3 && length <= 9)
-						{
-							descriptor_bits.Push(0);
 							descriptor_bits.Push(1);
-							output.Write(((-distance >> (8 - 3)) & 0xF8) | ((10 - length) & 7));
-							output.Write(-distance & 0xFF);
+							output.Write(window[match->destination]);
 						}
-						else //if (length >= 10)
+						else
 						{
-							descriptor_bits.Push(0);
-							descriptor_bits.Push(1);
-							output.Write((-distance >> (8 - 3)) & 0xF8);
-							output.Write(-distance & 0xFF);
-							output.Write(length - 9);
+							const std::size_t distance = match->destination - match->source;
+							const std::size_t length = match->length;
+
+							if (length >= 2 && length <= 5 && distance <= 0x100)
+							{
+								descriptor_bits.Push(0);
+								descriptor_bits.Push(0);
+								output.Write(-distance & 0xFF);
+								descriptor_bits.Push(!!((length - 2) & 2));
+								descriptor_bits.Push(!!((length - 2) & 1));
+							}
+							else if (length >= 3 && length <= 9)
+							{
+								descriptor_bits.Push(0);
+								descriptor_bits.Push(1);
+								output.Write(((-distance >> (8 - 3)) & 0xF8) | ((10 - length) & 7));
+								output.Write(-distance & 0xFF);
+							}
+							else //if (length >= 10)
+							{
+								descriptor_bits.Push(0);
+								descriptor_bits.Push(1);
+								output.Write((-distance >> (8 - 3)) & 0xF8);
+								output.Write(-distance & 0xFF);
+								output.Write(length - 9);
+							}
 						}
 					}
-				}
+				};
+
+				// Produce a series of LZSS compression matches.
+				if (!ClownLZSS::ParseOptimalMatches<Format>(workspace, settings, data, data_size, write_matches))
+					return false;
 
 				// Add the terminator match.
 				descriptor_bits.Push(0);
@@ -106,21 +121,40 @@ namespace ClownLZSS
 	}
 
 	template<typename T>
-	bool KosinskiPlusCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	bool KosinskiPlusCompress(const unsigned char* const data, const std::size_t data_size, T &&output, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return KosinskiPlus::Compress(data, data_size, output_wrapped);
+		return KosinskiPlus::Compress(data, data_size, output_wrapped, workspace, settings);
 	}
 
 	template<typename T>
-	bool ModuledKosinskiPlusCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	bool KosinskiPlusCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	{
+		Workspace workspace;
+		return KosinskiPlusCompress(data, data_size, std::forward<T>(output), workspace);
+	}
+
+	template<typename T>
+	bool ModuledKosinskiPlusCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return ModuledCompressionWrapper(data, data_size, output_wrapped, KosinskiPlus::Compress, module_size, 1);
+		return ModuledCompressionWrapper(data, data_size, output_wrapped, KosinskiPlus::Compress, module_size, 1, workspace, settings);
+	}
+
+	template<typename T>
+	bool ModuledKosinskiPlusCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	{
+		Workspace workspace;
+		return ModuledKosinskiPlusCompress(data, data_size, std::forward<T>(output), module_size, workspace);
+	}
+
+	inline ClownLZSS_CandidateFormat GetKosinskiPlusCandidateFormat()
+	{
+		return GetCandidateFormat<Internal::KosinskiPlus::Format>();
 	}
 }
 
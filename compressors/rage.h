@@ -36,138 +36,151 @@ namespace ClownLZSS
 					return 0;
 			}
 
-			inline void FindExtraMatches(const unsigned char* const data, const std::size_t data_size, const std::size_t offset, ClownLZSS_GraphEdge* const node_meta_array, [[maybe_unused]] void* const user)
+			inline void FindExtraMatches(const unsigned char* const data, [[maybe_unused]] const std::size_t data_size, const std::size_t offset, const std::size_t run_length, ClownLZSS_GraphEdge* const node_meta_array, [[maybe_unused]] void* const user)
 			{
 				std::size_t max_read_ahead;
 				std::size_t k;
 
-				// Look for RLE-matches.
-				max_read_ahead = std::min<std::size_t>(0xFFF + 4, data_size - offset);
+				// Add RLE-matches for the run that begins here. They are at least 4 bytes long.
+				max_read_ahead = std::min<std::size_t>(0xFFF + 4, run_length);
 
-				for (k = 0; k < max_read_ahead; ++k)
+				for (k = 4 - 1; k < max_read_ahead; ++k)
 				{
-					if (data[offset + k] == data[offset])
-					{
-						unsigned int cost;
-
-						if (k + 1 < 4)
-							cost = 0;
-						else
-							cost = ((k + 1 - 4 > 0xF ? 2 : 1) + 1) * 8;
-
-						if (cost && node_meta_array[offset + k + 1].u.cost > node_meta_array[offset].u.cost + cost)
-						{
-							node_meta_array[offset + k + 1].u.cost = node_meta_array[offset].u.cost + cost;
-							node_meta_array[offset + k + 1].previous_node_index = offset;
-							node_meta_array[offset + k + 1].match_offset = 0xFFFFFF00 | data[offset];	// Horrible hack, like the rest of this compressor.
-						}
-					}
-					else
-						break;
-				}
-
-				// Add uncompressed runs.
-				max_read_ahead = std::min<std::size_t>(0x1FFF, data_size - offset);
-
-				for (k = 0; k < max_read_ahead; ++k)
-				{
-					const unsigned int cost = (k + 1 + (k + 1 > 0x1F ? 2 : 1)) * 8;
+					const unsigned int cost = ((k + 1 - 4 > 0xF ? 2 : 1) + 1) * 8;
 
-					if (cost && node_meta_array[offset + k + 1].u.cost > node_meta_array[offset].u.cost + cost)
+					if (node_meta_array[offset + k + 1].u.cost > node_meta_array[offset].u.cost + cost)
 					{
 						node_meta_array[offset + k + 1].u.cost = node_meta_array[offset].u.cost + cost;
 						node_meta_array[offset + k + 1].previous_node_index = offset;
-						node_meta_array[offset + k + 1].match_offset = offset;	// Points at itself.
+						node_meta_array[offset + k + 1].match_offset = 0xFFFFFF00 | data[offset];	// Horrible hack, like the rest of this compressor.
 					}
 				}
+
+				// Uncompressed runs are relaxed by the parser itself: see `literal_run_length_tiers` below.
 			}
 
-			template<typename T>
-			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output)
+			struct Format
 			{
-				// Produce a series of LZSS compression matches.
-				// Yes, the distance really is 1 lower than usual.
-				ClownLZSS::Matches matches;
-				std::size_t total_matches;
-				if (!ClownLZSS::FindOptimalMatches(-1, 0xFFFFFFFF/*dictionary-matches can be infinite*/, 0x1FFF, FindExtraMatches, 0xFFFFFFF/*dummy*/, GetMatchCost, data, 1, data_size, &matches, &total_matches, nullptr))
-					return false;
+				static constexpr int filler_value = -1;
+				static constexpr std::size_t maximum_match_length = 0xFFFFFFFF; // Dictionary-matches can be infinite.
+				static constexpr std::size_t maximum_match_distance = 0x1FFF;
+				static constexpr std::size_t bytes_per_value = 1;
+				static constexpr std::size_t literal_cost = 0xFFFFFFF; // Dummy: literals are encoded as uncompressed runs by FindExtraMatches.
+				static constexpr MatchCostCallback GetMatchCost = Rage::GetMatchCost;
+				static constexpr std::size_t cost_distance_tiers[] = {0x1FFF};
+				static constexpr ExtraRunMatchesCallback FindExtraRunMatches = Rage::FindExtraMatches;
+				static constexpr std::size_t maximum_extra_match_length = 0xFFF + 4;
+				// Uncompressed runs have a one-byte header up to 0x1F bytes, and a two-byte header up to 0x1FFF bytes.
+				static constexpr std::size_t literal_run_length_tiers[] = {0x1F, 0x1FFF};
+				static constexpr std::size_t literal_run_header_costs[] = {1 * 8, 2 * 8};
+				static constexpr std::size_t literal_run_value_cost = 1 * 8;
+				// Up to 0x1F bytes can be copied from the distance of the last dictionary-match with a single byte.
+				static constexpr std::size_t maximum_repeat_match_length = 0x1F;
+				static constexpr std::size_t repeat_match_cost = 1 * 8;
+			};
 
+			template<typename T>
+			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output, Workspace &workspace, const ClownLZSS_Settings &settings)
+			{
 				// Track the location of the header...
 				const auto header_position = output.Tell();
 
 				// ...and insert a placeholder there.
 				output.WriteLE16(0);
 
+				// The decompressor remembers the distance of the last dictionary-match.
+				std::size_t last_distance = 0;
+
 				// Produce Rage-formatted data.
-				for (ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
+				const auto write_matches = [&](const unsigned char* const window, std::size_t, const ClownLZSS_Match* const matches, const std::size_t total_matches)
 				{
-					const std::size_t distance = match->destination - match->source;
-					const std::size_t offset = match->source;
+					for (const ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
+					{
+						const std::size_t distance = match->destination - match->source;
+						const std::size_t offset = match->source;
 
-					std::size_t length;
+						std::size_t length;
 
-					length = match->length;
+						length = match->length;
 
-					if (distance == 0)
-					{
-						std::size_t i;
-
-						// Uncompressed run.
-						if (length > 0x1F)
+						if (distance == 0)
 						{
-							output.Write(0x20 | ((length >> 8) & 0x1F));
-							output.Write(length & 0xFF);
+							std::size_t i;
+
+							// Uncompressed run.
+							if (length > 0x1F)
+							{
+								output.Write(0x20 | ((length >> 8) & 0x1F));
+								output.Write(length & 0xFF);
+							}
+							else
+							{
+								output.Write(length);
+							}
+
+							for (i = 0; i < length; ++i)
+								output.Write(window[offset + i]);
 						}
-						else
+						else if ((offset & 0xFFFFFF00) == 0xFFFFFF00)
 						{
-							output.Write(length);
+							// RLE-match.
+							length -= 4;
+
+							if (length > 0xF)
+							{
+								output.Write(0x40 | 0x10 | ((length >> 8) & 0xF));
+								output.Write(length & 0xFF);
+							}
+							else
+							{
+								output.Write(0x40 | (length & 0xF));
+							}
+
+							output.Write(offset & 0xFF);
 						}
-
-						for (i = 0; i < length; ++i)
-							output.Write(data[offset + i]);
-					}
-					else if ((offset & 0xFFFFFF00) == 0xFFFFFF00)
-					{
-						// RLE-match.
-						length -= 4;
-
-						if (length > 0xF)
+						else if (distance == last_distance)
 						{
-							output.Write(0x40 | 0x10 | ((length >> 8) & 0xF));
-							output.Write(length & 0xFF);
+							// Repeat the last dictionary-match's distance, in blocks of 0x1F bytes.
+							while (length != 0)
+							{
+								const std::size_t thing = length > 0x1F ? 0x1F : length;
+
+								output.Write(0x60 | thing);
+								length -= thing;
+							}
 						}
 						else
 						{
-							output.Write(0x40 | (length & 0xF));
-						}
-
-						output.Write(offset & 0xFF);
-					}
-					else
-					{
-						std::size_t thing;
+							std::size_t thing;
 
-						// Dictionary-match.
-						length -= 4;
+							// Dictionary-match.
+							last_distance = distance;
+							length -= 4;
 
-						// The first match can only encode 7 bytes.
-						thing = length > 3 ? 3 : length;
+							// The first match can only encode 7 bytes.
+							thing = length > 3 ? 3 : length;
 
-						output.Write(0x80 | (thing << 5) | ((distance >> 8) & 0x1F));
-						output.Write(distance & 0xFF);
+							output.Write(0x80 | (thing << 5) | ((distance >> 8) & 0x1F));
+							output.Write(distance & 0xFF);
 
-						length -= thing;
+							length -= thing;
 
-						// If there are still more bytes in this match, do them in blocks of 0x1F bytes.
-						while (length != 0)
-						{
-							thing = length > 0x1F ? 0x1F : length;
+							// If there are still more bytes in this match, do them in blocks of 0x1F bytes.
+							while (length != 0)
+							{
+								thing = length > 0x1F ? 0x1F : length;
 
-							output.Write(0x60 | thing);
-							length -= thing;
+								output.Write(0x60 | thing);
+								length -= thing;
+							}
 						}
 					}
-				}
+				};
+
+				// Produce a series of LZSS compression matches.
+				// Yes, the distance really is 1 lower than usual.
+				if (!ClownLZSS::ParseOptimalMatches<Format>(workspace, settings, data, data_size, write_matches))
+					return false;
 
 				// Grab the current position for later.
 				const auto end_position = output.Tell();
@@ -187,21 +200,40 @@ namespace ClownLZSS
 	}
 
 	template<typename T>
-	bool RageCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	bool RageCompress(const unsigned char* const data, const std::size_t data_size, T &&output, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return Rage::Compress(data, data_size, output_wrapped);
+		return Rage::Compress(data, data_size, output_wrapped, workspace, settings);
 	}
 
 	template<typename T>
-	bool ModuledRageCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	bool RageCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	{
+		Workspace workspace;
+		return RageCompress(data, data_size, std::forward<T>(output), workspace);
+	}
+
+	template<typename T>
+	bool ModuledRageCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return ModuledCompressionWrapper(data, data_size, output_wrapped, Rage::Compress, module_size, 2);
+		return ModuledCompressionWrapper(data, data_size, output_wrapped, Rage::Compress, module_size, 2, workspace, settings);
+	}
+
+	template<typename T>
+	bool ModuledRageCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	{
+		Workspace workspace;
+		return ModuledRageCompress(data, data_size, std::forward<T>(output), module_size, workspace);
+	}
+
+	inline ClownLZSS_CandidateFormat GetRageCandidateFormat()
+	{
+		return GetCandidateFormat<Internal::Rage::Format>();
 	}
 }
 
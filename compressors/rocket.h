@@ -36,15 +36,23 @@ namespace ClownLZSS
 				return 1 + 16;	// Descriptor bit, offset/length bytes.
 			}
 
-			template<typename T>
-			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output)
+			struct Format
 			{
-				// Produce a series of LZSS compression matches.
-				ClownLZSS::Matches matches;
-				std::size_t total_matches;
-				if (!ClownLZSS::FindOptimalMatches(0x20, 0x40, 0x400, nullptr, 1 + 8, GetMatchCost, data, 1, data_size, &matches, &total_matches, nullptr))
-					return false;
+				static constexpr int filler_value = 0x20;
+				static constexpr std::size_t maximum_match_length = 0x40;
+				static constexpr std::size_t maximum_match_distance = 0x400;
+				static constexpr std::size_t bytes_per_value = 1;
+				static constexpr std::size_t literal_cost = 1 + 8;
+				static constexpr MatchCostCallback GetMatchCost = Rocket::GetMatchCost;
+				static constexpr std::size_t cost_distance_tiers[] = {0x400};
+				static constexpr std::size_t descriptor_field_bits = 8;
+				static constexpr std::size_t trailing_descriptor_bits = 0;
+				static constexpr bool descriptor_field_written_when_full = false;
+			};
 
+			template<typename T>
+			bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output, Workspace &workspace, const ClownLZSS_Settings &settings)
+			{
 				// Write the first part of the header.
 				output.WriteBE16(data_size);
 
@@ -57,23 +65,30 @@ namespace ClownLZSS
 				DescriptorFieldWriter<decltype(output)> descriptor_bits(output);
 
 				// Produce Rocket-formatted data.
-				for (ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
+				const auto write_matches = [&](const unsigned char* const window, const std::size_t position, const ClownLZSS_Match* const matches, const std::size_t total_matches)
 				{
-					if (CLOWNLZSS_MATCH_IS_LITERAL(match))
+					for (const ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
 					{
-						descriptor_bits.Push(1);
-						output.Write(data[match->destination]);
+						if (CLOWNLZSS_MATCH_IS_LITERAL(match))
+						{
+							descriptor_bits.Push(1);
+							output.Write(window[match->destination]);
+						}
+						else
+						{
+							const std::size_t offset = (position + match->source - 0x40) % 0x400;
+							const std::size_t length = match->length;
+
+							descriptor_bits.Push(0);
+							output.Write(((offset >> 8) & 3) | ((length - 1) << 2));
+							output.Write(offset & 0xFF);
+						}
 					}
-					else
-					{
-						const std::size_t offset = (match->source - 0x40) % 0x400;
-						const std::size_t length = match->length;
+				};
 
-						descriptor_bits.Push(0);
-						output.Write(((offset >> 8) & 3) | ((length - 1) << 2));
-						output.Write(offset & 0xFF);
-					}
-				}
+				// Produce a series of LZSS compression matches.
+				if (!ClownLZSS::ParseOptimalMatches<Format>(workspace, settings, data, data_size, write_matches))
+					return false;
 
 				// Grab the current position for later.
 				const auto end_position = output.Tell();
@@ -93,21 +108,40 @@ namespace ClownLZSS
 	}
 
 	template<typename T>
-	bool RocketCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	bool RocketCompress(const unsigned char* const data, const std::size_t data_size, T &&output, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return Rocket::Compress(data, data_size, output_wrapped);
+		return Rocket::Compress(data, data_size, output_wrapped, workspace, settings);
 	}
 
 	template<typename T>
-	bool ModuledRocketCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	bool RocketCompress(const unsigned char* const data, const std::size_t data_size, T &&output)
+	{
+		Workspace workspace;
+		return RocketCompress(data, data_size, std::forward<T>(output), workspace);
+	}
+
+	template<typename T>
+	bool ModuledRocketCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return ModuledCompressionWrapper(data, data_size, output_wrapped, Rocket::Compress, module_size, 2);
+		return ModuledCompressionWrapper(data, data_size, output_wrapped, Rocket::Compress, module_size, 2, workspace, settings);
+	}
+
+	template<typename T>
+	bool ModuledRocketCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
+	{
+		Workspace workspace;
+		return ModuledRocketCompress(data, data_size, std::forward<T>(output), module_size, workspace);
+	}
+
+	inline ClownLZSS_CandidateFormat GetRocketCandidateFormat()
+	{
+		return GetCandidateFormat<Internal::Rocket::Format>();
 	}
 }
 
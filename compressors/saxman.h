@@ -40,15 +40,15 @@ namespace ClownLZSS
 					return 0;
 			}
 
-			inline void FindExtraMatches(const unsigned char* const data, const std::size_t total_values, const std::size_t offset, ClownLZSS_GraphEdge* const node_meta_array, [[maybe_unused]] void* const user)
+			inline void FindExtraMatches(const unsigned char* const data, [[maybe_unused]] const std::size_t total_values, const std::size_t offset, const std::size_t run_length, ClownLZSS_GraphEdge* const node_meta_array, [[maybe_unused]] void* const user)
 			{
-				if (offset < 0x1000)
+				if (offset < 0x1000 && data[offset] == 0)
 				{
 					std::size_t i;
 
-					const std::size_t max_read_ahead = std::min<std::size_t>(0x12, total_values - offset);
+					const std::size_t max_read_ahead = std::min<std::size_t>(0x12, run_length);
 
-					for (i = 0; i < max_read_ahead && data[offset + i] == 0; ++i)
+					for (i = 0; i < max_read_ahead; ++i)
 					{
 						const unsigned int cost = GetMatchCost(0, i + 1, user);
 
@@ -62,41 +62,55 @@ namespace ClownLZSS
 				}
 			}
 
-			template<typename T>
-			inline bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output)
+			struct Format
 			{
-				// Produce a series of LZSS compression matches.
-				ClownLZSS::Matches matches;
-				std::size_t total_matches;
-				if (!ClownLZSS::FindOptimalMatches(-1, 0x12, 0x1000, FindExtraMatches, 1 + 8, GetMatchCost, data, 1, data_size, &matches, &total_matches, nullptr))
-					return false;
+				static constexpr int filler_value = -1;
+				static constexpr std::size_t maximum_match_length = 0x12;
+				static constexpr std::size_t maximum_match_distance = 0x1000;
+				static constexpr std::size_t bytes_per_value = 1;
+				static constexpr std::size_t literal_cost = 1 + 8;
+				static constexpr MatchCostCallback GetMatchCost = Saxman::GetMatchCost;
+				static constexpr std::size_t cost_distance_tiers[] = {0x1000};
+				static constexpr ExtraRunMatchesCallback FindExtraRunMatches = Saxman::FindExtraMatches;
+				static constexpr std::size_t maximum_extra_match_length = 0x12;
+				static constexpr std::size_t descriptor_field_bits = 8;
+				static constexpr std::size_t trailing_descriptor_bits = 0;
+				static constexpr bool descriptor_field_written_when_full = false;
+			};
 
+			template<typename T>
+			inline bool Compress(const unsigned char* const data, const std::size_t data_size, CompressorOutput<T> &output, Workspace &workspace, const ClownLZSS_Settings &settings)
+			{
 				DescriptorFieldWriter<decltype(output)> descriptor_bits(output);
 
 				// Produce Saxman-formatted data.
-				for (ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
+				const auto write_matches = [&](const unsigned char* const window, const std::size_t position, const ClownLZSS_Match* const matches, const std::size_t total_matches)
 				{
-					if (CLOWNLZSS_MATCH_IS_LITERAL(match))
+					for (const ClownLZSS_Match *match = &matches[0]; match != &matches[total_matches]; ++match)
 					{
-						descriptor_bits.Push(1);
-						output.Write(data[match->destination]);
-					}
-					else
-					{
-						const std::size_t offset = match->source - 0x12;
-						const std::size_t length = match->length;
+						if (CLOWNLZSS_MATCH_IS_LITERAL(match))
+						{
+							descriptor_bits.Push(1);
+							output.Write(window[match->destination]);
+						}
+						else
+						{
+							const std::size_t offset = position + match->source - 0x12;
+							const std::size_t length = match->length;
 
-						descriptor_bits.Push(0);
-						output.Write(offset & 0xFF);
-						output.Write(((offset & 0xF00) >> 4) | (length - 3));
+							descriptor_bits.Push(0);
+							output.Write(offset & 0xFF);
+							output.Write(((offset & 0xF00) >> 4) | (length - 3));
+						}
 					}
-				}
+				};
 
-				return true;
+				// Produce a series of LZSS compression matches.
+				return ClownLZSS::ParseOptimalMatches<Format>(workspace, settings, data, data_size, write_matches);
 			}
 
 			template<typename T>
-			inline bool CompressWithHeader(const unsigned char* const data, const std::size_t data_size, T &&output)
+			inline bool CompressWithHeader(const unsigned char* const data, const std::size_t data_size, T &&output, Workspace &workspace, const ClownLZSS_Settings &settings)
 			{
 				// Track the location of the header...
 				const auto header_position = output.Tell();
@@ -104,7 +118,7 @@ namespace ClownLZSS
 				// ...and insert a placeholder there.
 				output.WriteLE16(0);
 
-				if (!Compress(data, data_size, output))
+				if (!Compress(data, data_size, output, workspace, settings))
 					return false;
 
 				// Grab the current position for later.
@@ -123,38 +137,64 @@ namespace ClownLZSS
 			}
 
 			template<typename T>
-			inline bool CompressWithoutHeader(const unsigned char* const data, const std::size_t data_size, T &&output)
+			inline bool CompressWithoutHeader(const unsigned char* const data, const std::size_t data_size, T &&output, Workspace &workspace, const ClownLZSS_Settings &settings)
 			{
-				return Compress(data, data_size, output);
+				return Compress(data, data_size, output, workspace, settings);
 			}
 		}
 	}
 
+	template<typename T>
+	bool SaxmanCompressWithoutHeader(const unsigned char* const data, const std::size_t data_size, T &&output, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
+	{
+		using namespace Internal;
+
+		CompressorOutput output_wrapped(std::forward<T>(output));
+		return Saxman::CompressWithoutHeader(data, data_size, output_wrapped, workspace, settings);
+	}
+
 	template<typename T>
 	bool SaxmanCompressWithoutHeader(const unsigned char* const data, const std::size_t data_size, T &&output)
+	{
+		Workspace workspace;
+		return SaxmanCompressWithoutHeader(data, data_size, std::forward<T>(output), workspace);
+	}
+
+	template<typename T>
+	bool SaxmanCompressWithHeader(const unsigned char* const data, const std::size_t data_size, T &&output, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return Saxman::CompressWithoutHeader(data, data_size, output_wrapped);
+		return Saxman::CompressWithHeader(data, data_size, output_wrapped, workspace, settings);
 	}
 
 	template<typename T>
 	bool SaxmanCompressWithHeader(const unsigned char* const data, const std::size_t data_size, T &&output)
+	{
+		Workspace workspace;
+		return SaxmanCompressWithHeader(data, data_size, std::forward<T>(output), workspace);
+	}
+
+	template<typename T>
+	bool ModuledSaxmanCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size, Workspace &workspace, const ClownLZSS_Settings &settings = Internal::GetDefaultSettings())
 	{
 		using namespace Internal;
 
 		CompressorOutput output_wrapped(std::forward<T>(output));
-		return Saxman::CompressWithHeader(data, data_size, output_wrapped);
+		return ModuledCompressionWrapper(data, data_size, output_wrapped, Saxman::CompressWithHeader, module_size, 2, workspace, settings);
 	}
 
 	template<typename T>
 	bool ModuledSaxmanCompress(const unsigned char* const data, const std::size_t data_size, T &&output, const std::size_t module_size)
 	{
-		using namespace Internal;
+		Workspace workspace;
+		return ModuledSaxmanCompress(data, data_size, std::forward<T>(output), module_size, workspace);
+	}
 
-		CompressorOutput output_wrapped(std::forward<T>(output));
-		return ModuledCompressionWrapper(data, data_size, output_wrapped, Saxman::CompressWithHeader, module_size, 2);
+	inline ClownLZSS_CandidateFormat GetSaxmanCandidateFormat()
+	{
+		return GetCandidateFormat<Internal::Saxman::Format>();
 	}
 }
 
@@ -20,10 +20,14 @@ PERFORMANCE OF THIS SOFTWARE.
 #include <array>
 #include <iterator>
 #if __STDC_HOSTED__
+	#include <cstddef>
 	#include <istream>
 	#include <ostream>
 #endif
 #include <type_traits>
+#if __STDC_HOSTED__
+	#include <vector>
+#endif
 
 #include "../common.h"
 
@@ -339,6 +343,130 @@ namespace ClownLZSS
 	};
 	#endif
 
+	#if __STDC_HOSTED__
+	// Decompressing into this keeps the copies as well as the data, so that they can be given to a compressor of another
+	// format as hints (see `ClownLZSS_Settings::hints`). Like the hints, the copies are in bytes. Copies that reach into the
+	// filler values before the data are not kept.
+	struct DecompressedCopies
+	{
+		struct Copy
+		{
+			std::size_t source;
+			std::size_t destination;
+			std::size_t length;
+		};
+
+		std::vector<unsigned char> data;
+		std::vector<Copy> copies;
+	};
+
+	namespace Internal
+	{
+		// This comes before the other bases, so that the output is ready by the time that they reset it.
+		class DecompressedCopiesOutputState
+		{
+		protected:
+			DecompressedCopies &output;
+			std::size_t start = 0;
+
+		public:
+			DecompressedCopiesOutputState(DecompressedCopies &output)
+				: output(output)
+			{}
+		};
+	}
+
+	template<typename T, unsigned int dictionary_size, unsigned int maximum_copy_length, int filler_value>
+	requires std::is_same_v<std::remove_cvref_t<T>, DecompressedCopies>
+	class DecompressorOutput<T, dictionary_size, maximum_copy_length, filler_value> : protected Internal::DecompressedCopiesOutputState, public Internal::OutputCommonBase<DecompressorOutput<T, dictionary_size, maximum_copy_length, filler_value>>
+	{
+	protected:
+		using Base = Internal::OutputCommonBase<DecompressorOutput<T, dictionary_size, maximum_copy_length, filler_value>>;
+
+		void WriteImplementation(const unsigned char value)
+		{
+			output.data.push_back(value);
+		}
+
+		void ResetImplementation()
+		{
+			start = output.data.size();
+		}
+
+	public:
+		using pos_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+		DecompressorOutput(DecompressedCopies &output)
+			: DecompressedCopiesOutputState(output)
+		{}
+
+		void Copy(const unsigned int raw_distance, const unsigned int count)
+		{
+			// Like the dictionary of the stream output, a distance of 0 wraps around to the whole dictionary.
+			const std::size_t distance = (raw_distance + dictionary_size - 1) % dictionary_size + 1;
+			const std::size_t position = output.data.size();
+
+			if (position - start >= distance)
+				output.copies.push_back({position - distance, position, count});
+
+			for (std::size_t i = position; i < position + count; ++i)
+			{
+				if constexpr(filler_value != -1)
+				{
+					if (i - start < distance)
+					{
+						Base::Write(filler_value);
+						continue;
+					}
+				}
+
+				Base::Write(output.data[i - distance]);
+			}
+		}
+
+		pos_type Tell() const
+		{
+			return output.data.size();
+		};
+
+		difference_type Distance(const pos_type &first) const
+		{
+			return Distance(first, Tell());
+		}
+
+		static difference_type Distance(const pos_type &first, const pos_type &last)
+		{
+			return last - first;
+		}
+
+		friend Base;
+	};
+
+	// Formats without copies just keep the data.
+	template<typename T>
+	requires std::is_same_v<std::remove_cvref_t<T>, DecompressedCopies>
+	class DecompressorOuputBasic<T> : public Internal::OutputCommonBase<DecompressorOuputBasic<T>>
+	{
+	protected:
+		using Base = Internal::OutputCommonBase<DecompressorOuputBasic<T>>;
+
+		DecompressedCopies &output;
+
+		void WriteImplementation(const unsigned char value)
+		{
+			output.data.push_back(value);
+		}
+
+	public:
+		DecompressorOuputBasic(DecompressedCopies &output)
+			: output(output)
+		{}
+
+		friend Base;
+	};
+	#endif
+
 	namespace Internal
 	{
 		template<typename T1, typename T2>
@@ -13,6 +13,7 @@ OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <filesystem>
@@ -20,6 +21,7 @@ PERFORMANCE OF THIS SOFTWARE.
 #include <iostream>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #include "compressors/chameleon.h"
@@ -105,7 +107,34 @@ static void PrintUsage(void)
 		" Misc:\n"
 		"  -m[=MODULE_SIZE]  Compresses into modules\n"
 		"                    MODULE_SIZE controls the module size (defaults to 0x1000)\n"
+		"  -p[=HORIZON]      Parses a piece at a time, to limit memory usage\n"
+		"                    HORIZON controls the piece size (defaults to 0x10000)\n"
+		"  -1 ... -9         Compresses faster (-1) or smaller (-9, the default)\n"
+		"  -l                Compresses much faster, but larger, by parsing lazily\n"
+		"  -a=MATCH_FINDER   Searches for matches with MATCH_FINDER, which is 'hash-chain',\n"
+		"                    'binary-tree', or 'suffix-array' (defaults to whichever\n"
+		"                    suits the format)\n"
+		"  -t[=THREADS]      Searches for matches on several threads\n"
+		"                    THREADS defaults to the number of CPU cores\n"
+		"  -b[=BLOCK_SIZE]   Parses blocks separately, so that -t can parse several at\n"
+		"                    once, at the cost of slightly larger output\n"
+		"                    BLOCK_SIZE controls the block size (defaults to 0x100000)\n"
+		"  -x                Compresses slightly smaller, but slower, by counting the\n"
+		"                    descriptor fields exactly (not with -p or -b)\n"
+		"  -i[=CHECKPOINT]   Keeps a checkpoint of the parse, so that compressing a\n"
+		"                    changed file again only parses it from the first change\n"
+		"                    (not with -m, -p, -b, or -l)\n"
+		"                    CHECKPOINT controls the checkpoint file (defaults to the\n"
+		"                    output file with '.checkpoint' appended)\n"
+		"  -g=FORMAT         Converts from FORMAT (such as 'k' for Kosinski), by only\n"
+		"                    trying the matches of the input file instead of searching\n"
+		"                    for them: much faster, but not as small (not with -m)\n"
 		"  -d     Decompress\n"
+		"\n"
+		" Several formats can be given at once, to compress the file into each of them,\n"
+		" which only searches it once for the ones that allow it. Each output file is\n"
+		" named after out-filename, with the extension of the format, which is .saxn for\n"
+		" -sn (not with -m, -d, or -i).\n"
 	;
 }
 
@@ -122,15 +151,244 @@ static auto FileToBuffer(const std::filesystem::path &path)
 	return buffer;
 }
 
+template<typename T1, typename T2>
+static void Decompress(const Mode &mode, const bool moduled, T1 &&input, T2 &&output, const std::filesystem::path &in_filename)
+{
+	switch (mode.format)
+	{
+		case Format::CHAMELEON:
+			if (moduled)
+				ClownLZSS::ModuledChameleonDecompress(input, output);
+			else
+				ClownLZSS::ChameleonDecompress(input, output);
+			break;
+
+		case Format::COMPER:
+			if (moduled)
+				ClownLZSS::ModuledComperDecompress(input, output);
+			else
+				ClownLZSS::ComperDecompress(input, output);
+			break;
+
+		case Format::ENIGMA:
+			if (moduled)
+				ClownLZSS::ModuledEnigmaDecompress(input, output);
+			else
+				ClownLZSS::EnigmaDecompress(input, output);
+			break;
+
+		case Format::FAXMAN:
+			if (moduled)
+				ClownLZSS::ModuledFaxmanDecompress(input, output);
+			else
+				ClownLZSS::FaxmanDecompress(input, output);
+			break;
+
+		case Format::KOSINSKI:
+			if (moduled)
+				ClownLZSS::ModuledKosinskiDecompress(input, output);
+			else
+				ClownLZSS::KosinskiDecompress(input, output);
+			break;
+
+		case Format::KOSINSKIPLUS:
+			if (moduled)
+				ClownLZSS::ModuledKosinskiPlusDecompress(input, output);
+			else
+				ClownLZSS::KosinskiPlusDecompress(input, output);
+			break;
+
+		case Format::RAGE:
+			if (moduled)
+				ClownLZSS::ModuledRageDecompress(input, output);
+			else
+				ClownLZSS::RageDecompress(input, output);
+			break;
+
+		case Format::ROCKET:
+			if (moduled)
+				ClownLZSS::ModuledRocketDecompress(input, output);
+			else
+				ClownLZSS::RocketDecompress(input, output);
+			break;
+
+		case Format::SAXMAN:
+			if (moduled)
+				ClownLZSS::ModuledSaxmanDecompress(input, output);
+			else
+				ClownLZSS::SaxmanDecompress(input, output);
+			break;
+
+		case Format::SAXMAN_NO_HEADER:
+			if (moduled)
+				ClownLZSS::ModuledSaxmanDecompress(input, output);
+			else
+				ClownLZSS::SaxmanDecompress(input, output, std::filesystem::file_size(in_filename));
+			break;
+		
+		case Format::NLZ:
+			break;
+	}
+}
+
+static bool Compress(const Mode &mode, const bool moduled, const std::size_t module_size, const std::vector<unsigned char> &file_buffer, std::ofstream &out_file, ClownLZSS::Workspace &workspace, const ClownLZSS_Settings &settings)
+{
+	switch (mode.format)
+	{
+		case Format::CHAMELEON:
+			if (moduled)
+				return ClownLZSS::ModuledChameleonCompress(file_buffer.data(), file_buffer.size(), out_file, module_size, workspace, settings);
+			else
+				return ClownLZSS::ChameleonCompress(file_buffer.data(), file_buffer.size(), out_file, workspace, settings);
+
+		case Format::COMPER:
+			if (moduled)
+				return ClownLZSS::ModuledComperCompress(file_buffer.data(), file_buffer.size(), out_file, module_size, workspace, settings);
+			else
+				return ClownLZSS::ComperCompress(file_buffer.data(), file_buffer.size(), out_file, workspace, settings);
+
+		case Format::ENIGMA:
+			if (moduled)
+				return ClownLZSS::ModuledEnigmaCompress(file_buffer.data(), file_buffer.size(), out_file, module_size, workspace, settings);
+			else
+				return ClownLZSS::EnigmaCompress(file_buffer.data(), file_buffer.size(), out_file, workspace, settings);
+
+		case Format::FAXMAN:
+			if (moduled)
+				return ClownLZSS::ModuledFaxmanCompress(file_buffer.data(), file_buffer.size(), out_file, module_size, workspace, settings);
+			else
+				return ClownLZSS::FaxmanCompress(file_buffer.data(), file_buffer.size(), out_file, workspace, settings);
+
+		case Format::KOSINSKI:
+			if (moduled)
+				return ClownLZSS::ModuledKosinskiCompress(file_buffer.data(), file_buffer.size(), out_file, module_size, workspace, settings);
+			else
+				return ClownLZSS::KosinskiCompress(file_buffer.data(), file_buffer.size(), out_file, workspace, settings);
+
+		case Format::KOSINSKIPLUS:
+			if (moduled)
+				return ClownLZSS::ModuledKosinskiPlusCompress(file_buffer.data(), file_buffer.size(), out_file, module_size, workspace, settings);
+			else
+				return ClownLZSS::KosinskiPlusCompress(file_buffer.data(), file_buffer.size(), out_file, workspace, settings);
+
+		case Format::RAGE:
+			if (moduled)
+				return ClownLZSS::ModuledRageCompress(file_buffer.data(), file_buffer.size(), out_file, module_size, workspace, settings);
+			else
+				return ClownLZSS::RageCompress(file_buffer.data(), file_buffer.size(), out_file, workspace, settings);
+
+		case Format::ROCKET:
+			if (moduled)
+				return ClownLZSS::ModuledRocketCompress(file_buffer.data(), file_buffer.size(), out_file, module_size, workspace, settings);
+			else
+				return ClownLZSS::RocketCompress(file_buffer.data(), file_buffer.size(), out_file, workspace, settings);
+
+		case Format::SAXMAN:
+			if (moduled)
+				return ClownLZSS::ModuledSaxmanCompress(file_buffer.data(), file_buffer.size(), out_file, module_size, workspace, settings);
+			else
+				return ClownLZSS::SaxmanCompressWithHeader(file_buffer.data(), file_buffer.size(), out_file, workspace, settings);
+
+		case Format::SAXMAN_NO_HEADER:
+			if (moduled)
+				return ClownLZSS::ModuledSaxmanCompress(file_buffer.data(), file_buffer.size(), out_file, module_size, workspace, settings);
+			else
+				return ClownLZSS::SaxmanCompressWithoutHeader(file_buffer.data(), file_buffer.size(), out_file, workspace, settings);
+		
+		case Format::NLZ:
+			if (moduled)
+				return ClownLZSS::ModuledNLZCompress(file_buffer.data(), file_buffer.size(), out_file, module_size, workspace, settings);
+			else
+				return ClownLZSS::NLZCompress(file_buffer.data(), file_buffer.size(), out_file, workspace, settings);
+	}
+
+	return false;
+}
+
+static bool GetCandidateFormat(const Format format, ClownLZSS_CandidateFormat &candidate_format)
+{
+	switch (format)
+	{
+		case Format::CHAMELEON:
+			candidate_format = ClownLZSS::GetChameleonCandidateFormat();
+			return true;
+
+		case Format::COMPER:
+			candidate_format = ClownLZSS::GetComperCandidateFormat();
+			return true;
+
+		case Format::ENIGMA:
+			return false;
+
+		case Format::FAXMAN:
+			candidate_format = ClownLZSS::GetFaxmanCandidateFormat();
+			return true;
+
+		case Format::KOSINSKI:
+			candidate_format = ClownLZSS::GetKosinskiCandidateFormat();
+			return true;
+
+		case Format::KOSINSKIPLUS:
+			candidate_format = ClownLZSS::GetKosinskiPlusCandidateFormat();
+			return true;
+
+		case Format::RAGE:
+			candidate_format = ClownLZSS::GetRageCandidateFormat();
+			return true;
+
+		case Format::ROCKET:
+			candidate_format = ClownLZSS::GetRocketCandidateFormat();
+			return true;
+
+		case Format::SAXMAN:
+		case Format::SAXMAN_NO_HEADER:
+			candidate_format = ClownLZSS::GetSaxmanCandidateFormat();
+			return true;
+
+		case Format::NLZ:
+			candidate_format = ClownLZSS::GetNLZCandidateFormat();
+			return true;
+	}
+
+	return false;
+}
+
+static std::filesystem::path GetOutputFilename(const Mode &mode, const bool moduled, const std::filesystem::path &out_filename, const bool several_formats)
+{
+	const std::filesystem::path default_filename = moduled ? mode.moduled_default_filename : mode.normal_default_filename;
+
+	// Each format is written to a file of its own, which is named after the output file.
+	if (several_formats)
+	{
+		std::filesystem::path extension = default_filename.extension();
+
+		// Both kinds of Saxman share a default filename, so the headerless one needs an extension of its own here.
+		if (mode.format == Format::SAXMAN_NO_HEADER)
+			extension = moduled ? ".saxnm" : ".saxn";
+
+		return std::filesystem::path(out_filename.empty() ? default_filename : out_filename).replace_extension(extension);
+	}
+
+	if (out_filename.empty())
+		return default_filename;
+
+	return out_filename;
+}
+
 int main(int argc, char **argv)
 {
 	int exit_code = EXIT_SUCCESS;
 
-	const Mode *mode = NULL;
+	std::vector<const Mode*> selected_modes;
+	const Mode *source_mode = NULL;
 	std::filesystem::path in_filename;
 	std::filesystem::path out_filename;
-	bool moduled = false, decompress = false;
+	std::filesystem::path checkpoint_filename;
+	bool moduled = false, decompress = false, checkpoint = false;
 	std::size_t module_size = 0x1000;
+	ClownLZSS_Settings settings;
+
+	ClownLZSS_InitialiseSettings(&settings);
 
 	/* Skip past the executable name */
 	--argc;
@@ -173,6 +431,147 @@ int main(int argc, char **argv)
 					}
 				}
 			}
+			else if (arg.size() == 2 && arg[1] >= '1' && arg[1] <= '9')
+			{
+				ClownLZSS_SetEffortLevel(&settings, arg[1] - '0');
+			}
+			else if (arg == "-l")
+			{
+				settings.parser = CLOWNLZSS_PARSER_LAZY;
+			}
+			else if (arg[1] == 'a')
+			{
+				const auto argument_position = arg.find_first_of('=');
+				const auto match_finder = argument_position != arg.npos ? arg.substr(argument_position + 1) : std::string_view();
+
+				if (match_finder == "hash-chain")
+				{
+					settings.match_finder = CLOWNLZSS_MATCH_FINDER_HASH_CHAIN;
+				}
+				else if (match_finder == "binary-tree")
+				{
+					settings.match_finder = CLOWNLZSS_MATCH_FINDER_BINARY_TREE;
+				}
+				else if (match_finder == "suffix-array")
+				{
+					settings.match_finder = CLOWNLZSS_MATCH_FINDER_SUFFIX_ARRAY;
+				}
+				else
+				{
+					std::cerr << "Invalid parameter to -a\n";
+					exit_code = EXIT_FAILURE;
+					break;
+				}
+			}
+			else if (arg[1] == 't')
+			{
+				settings.run_jobs = ClownLZSS::RunJobsOnThreads;
+				settings.total_jobs = std::max(1u, std::thread::hardware_concurrency());
+
+				const auto argument_position = arg.find_first_of('=');
+
+				if (argument_position != arg.npos)
+				{
+					char *end;
+					unsigned long result = std::strtoul(&argv[i][argument_position + 1], &end, 0);
+
+					if (*end != '\0' || result == 0)
+					{
+						std::cerr << "Invalid parameter to -t\n";
+						exit_code = EXIT_FAILURE;
+						break;
+					}
+					else
+					{
+						settings.total_jobs = result;
+					}
+				}
+			}
+			else if (arg[1] == 'b')
+			{
+				settings.block_size = 0x100000;
+
+				const auto argument_position = arg.find_first_of('=');
+
+				if (argument_position != arg.npos)
+				{
+					char *end;
+					unsigned long result = std::strtoul(&argv[i][argument_position + 1], &end, 0);
+
+					if (*end != '\0' || result == 0)
+					{
+						std::cerr << "Invalid parameter to -b\n";
+						exit_code = EXIT_FAILURE;
+						break;
+					}
+					else
+					{
+						settings.block_size = result;
+					}
+				}
+			}
+			else if (arg == "-x")
+			{
+				settings.exact_size = 1;
+			}
+			else if (arg[1] == 'g')
+			{
+				const auto argument_position = arg.find_first_of('=');
+
+				if (argument_position != arg.npos)
+				{
+					const auto command = arg.substr(argument_position + 1);
+
+					for (const auto &current_mode : modes)
+					{
+						if (current_mode.command.substr(1) == command)
+						{
+							source_mode = &current_mode;
+							break;
+						}
+					}
+				}
+
+				// There is no NLZ decompressor.
+				if (source_mode == NULL || source_mode->format == Format::NLZ)
+				{
+					std::cerr << "Invalid parameter to -g\n";
+					exit_code = EXIT_FAILURE;
+					break;
+				}
+			}
+			else if (arg[1] == 'i')
+			{
+				checkpoint = true;
+
+				const auto argument_position = arg.find_first_of('=');
+
+				if (argument_position != arg.npos)
+					checkpoint_filename = arg.substr(argument_position + 1);
+			}
+			else if (arg[1] == 'p')
+			{
+				settings.horizon = 0x10000;
+
+				const auto argument_position = arg.find_first_of('=');
+
+				if (argument_position != arg.npos)
+				{
+					char *end;
+					unsigned long result = std::strtoul(&argv[i][argument_position + 1], &end, 0);
+
+					if (*end != '\0' || result == 0)
+					{
+						std::cerr << "Invalid parameter to -p\n";
+						exit_code = EXIT_FAILURE;
+						break;
+					}
+					else
+					{
+						settings.horizon = result;
+					}
+				}
+			}
 			else if (arg == "-d")
 			{
 				decompress = true;
@@ -183,7 +582,9 @@ int main(int argc, char **argv)
 				{
 					if (arg == current_mode.command)
 					{
-						mode = &current_mode;
+						if (std::find(selected_modes.cbegin(), selected_modes.cend(), &current_mode) == selected_modes.cend())
+							selected_modes.push_back(&current_mode);
+
 						break;
 					}
 				}
@@ -200,193 +601,151 @@ int main(int argc, char **argv)
 
 	if (exit_code != EXIT_FAILURE)
 	{
+		const bool several_formats = selected_modes.size() > 1;
+
 		if (in_filename.empty())
 		{
 			exit_code = EXIT_FAILURE;
 			std::cerr << "Error: Input file not specified\n";
 			PrintUsage();
 		}
-		else if (mode == NULL)
+		else if (selected_modes.empty())
 		{
 			exit_code = EXIT_FAILURE;
 			std::cerr << "Error: Format not specified\n";
 			PrintUsage();
 		}
-		else
+		else if (source_mode != NULL && (moduled || decompress))
+		{
+			exit_code = EXIT_FAILURE;
+			std::cerr << "Error: -g cannot be used with -m or -d\n";
+		}
+		else if (several_formats && (moduled || decompress || checkpoint))
+		{
+			exit_code = EXIT_FAILURE;
+			std::cerr << "Error: Only one format can be used with -m, -d, or -i\n";
+		}
+		else if (decompress)
 		{
-			if (out_filename.empty())
-				out_filename = moduled ? mode->moduled_default_filename : mode->normal_default_filename;
+			const Mode &mode = *selected_modes[0];
 
 			std::ofstream out_file;
 			out_file.exceptions(out_file.badbit | out_file.eofbit | out_file.failbit);
-			out_file.open(out_filename, decompress ? out_file.trunc | out_file.in | out_file.out | out_file.binary : out_file.out | out_file.binary);
+			out_file.open(GetOutputFilename(mode, moduled, out_filename, false), out_file.trunc | out_file.in | out_file.out | out_file.binary);
 
-			if (decompress)
+			std::ifstream in_file;
+			in_file.exceptions(in_file.badbit | in_file.eofbit | in_file.failbit);
+			in_file.open(in_filename, in_file.in | in_file.binary);
+
+			Decompress(mode, moduled, in_file, out_file, in_filename);
+		}
+		else
+		{
+			if (checkpoint && checkpoint_filename.empty())
+				checkpoint_filename = GetOutputFilename(*selected_modes[0], moduled, out_filename, false).string() + ".checkpoint";
+
+			// The old checkpoint is only needed until the new one has been made.
+			std::vector<unsigned char> old_checkpoint, new_checkpoint;
+
+			if (checkpoint && !moduled)
 			{
-				std::ifstream in_file;
-				in_file.exceptions(in_file.badbit | in_file.eofbit | in_file.failbit);
-				in_file.open(in_filename, in_file.in | in_file.binary);
+				if (std::filesystem::exists(checkpoint_filename))
+				{
+					old_checkpoint = FileToBuffer(checkpoint_filename);
+					settings.checkpoint = old_checkpoint.data();
+					settings.checkpoint_size = old_checkpoint.size();
+				}
 
-				switch (mode->format)
+				settings.write_checkpoint = [](const unsigned char* const bytes, const std::size_t total_bytes, void* const user)
 				{
-					case Format::CHAMELEON:
-						if (moduled)
-							ClownLZSS::ModuledChameleonDecompress(in_file, out_file);
-						else
-							ClownLZSS::ChameleonDecompress(in_file, out_file);
-						break;
+					auto &new_checkpoint = *static_cast<std::vector<unsigned char>*>(user);
+					new_checkpoint.insert(new_checkpoint.end(), bytes, bytes + total_bytes);
+				};
+				settings.write_checkpoint_user = &new_checkpoint;
+			}
 
-					case Format::COMPER:
-						if (moduled)
-							ClownLZSS::ModuledComperDecompress(in_file, out_file);
-						else
-							ClownLZSS::ComperDecompress(in_file, out_file);
-						break;
+			// When converting, the copies of the input file are the only matches that are tried.
+			ClownLZSS::DecompressedCopies decompressed;
+			std::vector<ClownLZSS_Match> hints;
 
-					case Format::ENIGMA:
-						if (moduled)
-							ClownLZSS::ModuledEnigmaDecompress(in_file, out_file);
-						else
-							ClownLZSS::EnigmaDecompress(in_file, out_file);
-						break;
+			if (source_mode != NULL)
+			{
+				const auto compressed = FileToBuffer(in_filename);
 
-					case Format::FAXMAN:
-						if (moduled)
-							ClownLZSS::ModuledFaxmanDecompress(in_file, out_file);
-						else
-							ClownLZSS::FaxmanDecompress(in_file, out_file);
-						break;
+				Decompress(*source_mode, false, compressed.cbegin(), decompressed, in_filename);
 
-					case Format::KOSINSKI:
-						if (moduled)
-							ClownLZSS::ModuledKosinskiDecompress(in_file, out_file);
-						else
-							ClownLZSS::KosinskiDecompress(in_file, out_file);
-						break;
+				hints.reserve(decompressed.copies.size());
 
-					case Format::KOSINSKIPLUS:
-						if (moduled)
-							ClownLZSS::ModuledKosinskiPlusDecompress(in_file, out_file);
-						else
-							ClownLZSS::KosinskiPlusDecompress(in_file, out_file);
-						break;
+				for (const auto &copy : decompressed.copies)
+					hints.push_back({copy.source, copy.destination, copy.length});
 
-					case Format::RAGE:
-						if (moduled)
-							ClownLZSS::ModuledRageDecompress(in_file, out_file);
-						else
-							ClownLZSS::RageDecompress(in_file, out_file);
-						break;
+				settings.hints = hints.data();
+				settings.total_hints = hints.size();
+				settings.match_finder = CLOWNLZSS_MATCH_FINDER_HINTS;
+			}
 
-					case Format::ROCKET:
-						if (moduled)
-							ClownLZSS::ModuledRocketDecompress(in_file, out_file);
-						else
-							ClownLZSS::RocketDecompress(in_file, out_file);
-						break;
+			const auto file_buffer = source_mode != NULL ? std::move(decompressed.data) : FileToBuffer(in_filename);
+			ClownLZSS::Workspace workspace;
 
-					case Format::SAXMAN:
-						if (moduled)
-							ClownLZSS::ModuledSaxmanDecompress(in_file, out_file);
-						else
-							ClownLZSS::SaxmanDecompress(in_file, out_file);
-						break;
+			// When producing several formats, the data is only searched once for all of the ones that have the same
+			// values as the first. The candidates are only used by a whole, optimal parse that is not converting.
+			std::vector<ClownLZSS_CandidateFormat> candidate_formats;
+			std::vector<bool> uses_candidates;
+			std::vector<unsigned char> candidates;
 
-					case Format::SAXMAN_NO_HEADER:
-						if (moduled)
-							ClownLZSS::ModuledSaxmanDecompress(in_file, out_file);
-						else
-							ClownLZSS::SaxmanDecompress(in_file, out_file, std::filesystem::file_size(in_filename));
-						break;
-					
-					case Format::NLZ:
-						break;
-				}
+			for (const auto mode : selected_modes)
+			{
+				ClownLZSS_CandidateFormat candidate_format;
+				const bool uses = several_formats && source_mode == NULL && settings.parser == CLOWNLZSS_PARSER_OPTIMAL && settings.match_finder == CLOWNLZSS_MATCH_FINDER_AUTOMATIC && settings.horizon == 0 && settings.block_size == 0
+					&& GetCandidateFormat(mode->format, candidate_format)
+					&& (candidate_formats.empty() || (candidate_format.filler_value == candidate_formats[0].filler_value && candidate_format.bytes_per_value == candidate_formats[0].bytes_per_value));
+
+				if (uses)
+					candidate_formats.push_back(candidate_format);
+
+				uses_candidates.push_back(uses);
 			}
-			else
+
+			if (candidate_formats.size() < 2 || !ClownLZSS::FindCandidates(workspace, settings, candidate_formats.data(), candidate_formats.size(), file_buffer.data(), file_buffer.size() / candidate_formats[0].bytes_per_value, candidates))
+				candidates.clear();
+
+			for (std::size_t i = 0; i < selected_modes.size(); ++i)
 			{
-				const bool success = [&]() -> bool
-				{
-					const auto file_buffer = FileToBuffer(in_filename);
+				const Mode &mode = *selected_modes[i];
+				ClownLZSS_Settings mode_settings = settings;
 
-					switch (mode->format)
-					{
-						case Format::CHAMELEON:
-							if (moduled)
-								return ClownLZSS::ModuledChameleonCompress(file_buffer.data(), file_buffer.size(), out_file, module_size);
-							else
-								return ClownLZSS::ChameleonCompress(file_buffer.data(), file_buffer.size(), out_file);
-
-						case Format::COMPER:
-							if (moduled)
-								return ClownLZSS::ModuledComperCompress(file_buffer.data(), file_buffer.size(), out_file, module_size);
-							else
-								return ClownLZSS::ComperCompress(file_buffer.data(), file_buffer.size(), out_file);
-
-						case Format::ENIGMA:
-							if (moduled)
-								return ClownLZSS::ModuledEnigmaCompress(file_buffer.data(), file_buffer.size(), out_file, module_size);
-							else
-								return ClownLZSS::EnigmaCompress(file_buffer.data(), file_buffer.size(), out_file);
-
-						case Format::FAXMAN:
-							if (moduled)
-								return ClownLZSS::ModuledFaxmanCompress(file_buffer.data(), file_buffer.size(), out_file, module_size);
-							else
-								return ClownLZSS::FaxmanCompress(file_buffer.data(), file_buffer.size(), out_file);
-
-						case Format::KOSINSKI:
-							if (moduled)
-								return ClownLZSS::ModuledKosinskiCompress(file_buffer.data(), file_buffer.size(), out_file, module_size);
-							else
-								return ClownLZSS::KosinskiCompress(file_buffer.data(), file_buffer.size(), out_file);
-
-						case Format::KOSINSKIPLUS:
-							if (moduled)
-								return ClownLZSS::ModuledKosinskiPlusCompress(file_buffer.data(), file_buffer.size(), out_file, module_size);
-							else
-								return ClownLZSS::KosinskiPlusCompress(file_buffer.data(), file_buffer.size(), out_file);
-
-						case Format::RAGE:
-							if (moduled)
-								return ClownLZSS::ModuledRageCompress(file_buffer.data(), file_buffer.size(), out_file, module_size);
-							else
-								return ClownLZSS::RageCompress(file_buffer.data(), file_buffer.size(), out_file);
-
-						case Format::ROCKET:
-							if (moduled)
-								return ClownLZSS::ModuledRocketCompress(file_buffer.data(), file_buffer.size(), out_file, module_size);
-							else
-								return ClownLZSS::RocketCompress(file_buffer.data(), file_buffer.size(), out_file);
-
-						case Format::SAXMAN:
-							if (moduled)
-								return ClownLZSS::ModuledSaxmanCompress(file_buffer.data(), file_buffer.size(), out_file, module_size);
-							else
-								return ClownLZSS::SaxmanCompressWithHeader(file_buffer.data(), file_buffer.size(), out_file);
-
-						case Format::SAXMAN_NO_HEADER:
-							if (moduled)
-								return ClownLZSS::ModuledSaxmanCompress(file_buffer.data(), file_buffer.size(), out_file, module_size);
-							else
-								return ClownLZSS::SaxmanCompressWithoutHeader(file_buffer.data(), file_buffer.size(), out_file);
-						
-						case Format::NLZ:
-							if (moduled)
-								return ClownLZSS::ModuledNLZCompress(file_buffer.data(), file_buffer.size(), out_file, module_size);
-							else
-								return ClownLZSS::NLZCompress(file_buffer.data(), file_buffer.size(), out_file);
-					}
+				if (uses_candidates[i] && !candidates.empty())
+				{
+					mode_settings.candidates = candidates.data();
+					mode_settings.candidates_size = candidates.size();
+				}
 
-					return false;
-				}();
+				std::ofstream out_file;
+				out_file.exceptions(out_file.badbit | out_file.eofbit | out_file.failbit);
+				out_file.open(GetOutputFilename(mode, moduled, out_filename, several_formats), out_file.out | out_file.binary);
 
-				if (!success)
+				if (!Compress(mode, moduled, module_size, file_buffer, out_file, workspace, mode_settings))
 				{
 					exit_code = EXIT_FAILURE;
 					std::cerr << "Error: File could not be compressed\n";
 				}
 			}
+
+			if (exit_code != EXIT_FAILURE && checkpoint && !moduled)
+			{
+				// Nothing is written if the settings do not support checkpoints, in which case an old one would be stale.
+				if (new_checkpoint.empty())
+				{
+					std::filesystem::remove(checkpoint_filename);
+				}
+				else
+				{
+					std::ofstream checkpoint_file;
+					checkpoint_file.exceptions(checkpoint_file.badbit | checkpoint_file.eofbit | checkpoint_file.failbit);
+					checkpoint_file.open(checkpoint_filename, checkpoint_file.out | checkpoint_file.binary);
+					checkpoint_file.write(reinterpret_cast<const char*>(new_checkpoint.data()), new_checkpoint.size());
+				}
+			}
 		}
 	}
 
@@ -0,0 +1,96 @@
+/* Checks that the matches that begin in the filler values before the data come back with the right distance, and that
+   every match rebuilds the data. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../compressors/clownlzss.h"
+
+#define FILLER_VALUE 0
+#define MAXIMUM_MATCH_LENGTH 0x100
+#define MAXIMUM_MATCH_DISTANCE 0x2000
+#define TOTAL_VALUES 0x4000
+
+static size_t GetMatchCost(const size_t distance, const size_t length, void* const user)
+{
+	(void)distance;
+	(void)user;
+
+	return length >= 2 ? 18 : 0;
+}
+
+int main(void)
+{
+	static unsigned char data[TOTAL_VALUES];
+	static unsigned char rebuilt[TOTAL_VALUES];
+	unsigned long seed;
+	ClownLZSS_Match *matches;
+	size_t total_matches, total_filler_matches, i;
+	int success;
+
+	/* The data begins with a run of the filler value, so that the first match can begin before the data. */
+	memset(data, FILLER_VALUE, 0x40);
+
+	seed = 1;
+
+	for (i = 0x40; i < TOTAL_VALUES; ++i)
+	{
+		seed = (seed * 1103515245 + 12345) & 0xFFFFFFFF;
+		/* Few different values, so that there are plenty of matches. */
+		data[i] = (unsigned char)((seed >> 16) % 4);
+	}
+
+	if (!ClownLZSS_FindOptimalMatches(FILLER_VALUE, MAXIMUM_MATCH_LENGTH, MAXIMUM_MATCH_DISTANCE, NULL, 9, GetMatchCost, data, 1, TOTAL_VALUES, &matches, &total_matches, NULL))
+	{
+		fputs("Could not find the matches.\n", stderr);
+		return EXIT_FAILURE;
+	}
+
+	success = 1;
+	total_filler_matches = 0;
+
+	for (i = 0; i < total_matches; ++i)
+	{
+		const ClownLZSS_Match* const match = &matches[i];
+
+		if (CLOWNLZSS_MATCH_IS_LITERAL(match))
+		{
+			rebuilt[match->destination] = data[match->destination];
+		}
+		else
+		{
+			const size_t distance = match->destination - match->source;
+			size_t j;
+
+			if (distance == 0 || distance > MAXIMUM_MATCH_DISTANCE)
+			{
+				fprintf(stderr, "Match %lu has a distance of %lu.\n", (unsigned long)i, (unsigned long)distance);
+				success = 0;
+				break;
+			}
+
+			if (distance > match->destination)
+				++total_filler_matches;
+
+			for (j = 0; j < match->length; ++j)
+				rebuilt[match->destination + j] = distance > match->destination + j ? FILLER_VALUE : rebuilt[match->destination + j - distance];
+		}
+	}
+
+	free(matches);
+
+	if (success && total_filler_matches == 0)
+	{
+		fputs("No match began in the filler values.\n", stderr);
+		success = 0;
+	}
+
+	if (success && memcmp(data, rebuilt, TOTAL_VALUES) != 0)
+	{
+		fputs("The matches do not rebuild the data.\n", stderr);
+		success = 0;
+	}
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
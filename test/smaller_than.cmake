@@ -0,0 +1,15 @@
+# Fails unless the file SMALLER is smaller than the file LARGER.
+# Usage: cmake -DSMALLER=<file> -DLARGER=<file> -P smaller_than.cmake
+
+file(READ "${SMALLER}" smaller_contents HEX)
+file(READ "${LARGER}" larger_contents HEX)
+string(LENGTH "${smaller_contents}" smaller_size)
+string(LENGTH "${larger_contents}" larger_size)
+
+# Each byte is two hexadecimal digits.
+math(EXPR smaller_size "${smaller_size} / 2")
+math(EXPR larger_size "${larger_size} / 2")
+
+if(NOT smaller_size LESS larger_size)
+	message(FATAL_ERROR "'${SMALLER}' is ${smaller_size} bytes, which is not smaller than the ${larger_size} bytes of '${LARGER}'.")
+endif()